@@ -0,0 +1,215 @@
+/*
+ * File:   adc-capture.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 09:40
+ */
+
+#include "adc-capture.h"
+#include "clock.h"
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#define MASK (ADC_CAPTURE_SAMPLES - 1)
+
+static uint16_t ring[ADC_CAPTURE_SAMPLES];
+// Where the next sample goes.
+static uint16_t head;
+
+static volatile adc_capture_state state = ADC_CAPTURE_IDLE;
+static volatile bool done_untold = false;
+
+static adc_capture_trigger trigger_kind;
+static uint16_t trigger_level;
+static uint16_t pre_count;
+static uint16_t post_count;
+static uint32_t sample_hz;
+
+// Samples still to take in the current state.
+static uint16_t remaining;
+static uint16_t previous;
+static bool was_pressed;
+
+static bool is_trigger(uint16_t value, bool pressed)
+{
+    switch (trigger_kind)
+    {
+    case ADC_CAPTURE_RISING:
+        return (previous < trigger_level) && (value >= trigger_level);
+    case ADC_CAPTURE_FALLING:
+        return (previous >= trigger_level) && (value < trigger_level);
+    case ADC_CAPTURE_BUTTON:
+        return pressed && !was_pressed;
+    }
+    return false;
+}
+
+static void stop_sampling(void)
+{
+    TCB0.CTRLA = 0;
+    ADC0.EVCTRL = 0;
+    EVSYS.USERADC0 = EVSYS_CHANNEL_OFF_gc;
+    adc_release();
+}
+
+static void store_sample(uint16_t value)
+{
+    // The button is read along with each sample, so it triggers on the
+    // sample taken right after being pressed.
+    bool pressed = !(VPORTF.IN & PIN6_bm);
+    ring[head] = value;
+    head = (head + 1) & MASK;
+
+    switch (state)
+    {
+    case ADC_CAPTURE_FILLING:
+        // The first sample only gives the next one something to be
+        // compared with, so it has to be taken even without `pre`.
+        if (--remaining == 0)
+        {
+            state = ADC_CAPTURE_WAITING;
+        }
+        break;
+    case ADC_CAPTURE_WAITING:
+        if (is_trigger(value, pressed))
+        {
+            // The trigger is the first sample of `post`.
+            remaining = post_count - 1;
+            state = ADC_CAPTURE_TRIGGERED;
+        }
+        break;
+    case ADC_CAPTURE_TRIGGERED:
+        --remaining;
+        break;
+    default:
+        break;
+    }
+
+    if ((state == ADC_CAPTURE_TRIGGERED) && (remaining == 0))
+    {
+        stop_sampling();
+        state = ADC_CAPTURE_DONE;
+        done_untold = true;
+    }
+    previous = value;
+    was_pressed = pressed;
+}
+
+// Starts the timer ticking at `sample_hz`. Returns false if it can't.
+static bool start_timer(void)
+{
+    uint8_t clksel;
+    uint16_t period;
+    if (!clock_tcb_period((clock_hz() + sample_hz / 2) / sample_hz, &clksel,
+            &period))
+    {
+        return false;
+    }
+    TCB0.CTRLA = 0;
+    TCB0.CCMP = period;
+    TCB0.CNT = 0;
+    TCB0.CTRLA = clksel | TCB_ENABLE_bm;
+    return true;
+}
+
+bool adc_capture_start(const adc_config *config, uint32_t rate_hz,
+        uint16_t level, adc_capture_trigger trigger, uint16_t pre,
+        uint16_t post)
+{
+    // Requests only get converted where they don't hold a sample up.
+    if (!adc_claim(config, &store_sample, ADC_SHARE_IN_GAPS))
+    {
+        return false;
+    }
+
+    trigger_level = level;
+    trigger_kind = trigger;
+    pre_count = pre;
+    post_count = post;
+    head = 0;
+    remaining = (pre > 0) ? pre : 1;
+    was_pressed = !(VPORTF.IN & PIN6_bm);
+    done_untold = false;
+    state = ADC_CAPTURE_FILLING;
+
+    ADC_EVENT_CHANNEL = EVSYS_GENERATOR_TCB0_CAPT_gc;
+    EVSYS.USERADC0 = ADC_EVENT_USER;
+    ADC0.EVCTRL = ADC_STARTEI_bm;
+
+    sample_hz = rate_hz;
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.INTCTRL = 0;
+    if (!start_timer())
+    {
+        stop_sampling();
+        state = ADC_CAPTURE_IDLE;
+        return false;
+    }
+    return true;
+}
+
+void adc_capture_clock_changed(void)
+{
+    adc_capture_state now = state;
+    if ((now != ADC_CAPTURE_IDLE) && (now != ADC_CAPTURE_DONE)
+            && !start_timer())
+    {
+        adc_capture_stop();
+    }
+}
+
+void adc_capture_stop(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if ((state != ADC_CAPTURE_IDLE) && (state != ADC_CAPTURE_DONE))
+        {
+            stop_sampling();
+        }
+        state = ADC_CAPTURE_IDLE;
+        done_untold = false;
+    }
+}
+
+adc_capture_state adc_capture_get_state(void)
+{
+    return state;
+}
+
+bool adc_capture_take_done(void)
+{
+    bool done = done_untold;
+    done_untold = false;
+    return done;
+}
+
+uint16_t adc_capture_length(void)
+{
+    return (state == ADC_CAPTURE_DONE) ? pre_count + post_count : 0;
+}
+
+uint16_t adc_capture_trigger_index(void)
+{
+    return (state == ADC_CAPTURE_DONE) ? pre_count : 0;
+}
+
+uint16_t adc_capture_read(uint16_t from, uint16_t *samples, uint16_t count)
+{
+    uint16_t length = adc_capture_length();
+    if (from >= length)
+    {
+        return 0;
+    }
+    if (count > length - from)
+    {
+        count = length - from;
+    }
+
+    // The window ends with the newest sample, just before `head`.
+    uint16_t start = head - length + from;
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        samples[i] = ring[(start + i) & MASK];
+    }
+    return count;
+}
@@ -0,0 +1,87 @@
+/*
+ * File:   adc-capture.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 09:40
+ */
+
+#ifndef ADC_CAPTURE_H
+#define	ADC_CAPTURE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adc.h"
+
+// Capturing what happens around a trigger, like an oscilloscope.
+//
+// TCB0 paces the conversions through the event system like with streaming,
+// see adc-stream.h, and the interrupt stores them into a ring in SRAM. Once
+// the trigger has been seen, `post` more samples are taken, and then the
+// sampling stops, leaving the samples around the trigger in the ring to be
+// read at whatever pace.
+
+// The size of the ring, a power of two.
+#ifndef ADC_CAPTURE_SAMPLES
+#define ADC_CAPTURE_SAMPLES 512
+#endif
+
+typedef enum ADC_CAPTURE_TRIGGER {
+    // The value going from below the level to at or above it.
+    ADC_CAPTURE_RISING,
+    // The value going from at or above the level to below it.
+    ADC_CAPTURE_FALLING,
+    // The button on PF6 reading low, as in pressed, with BUTTON INV off.
+    ADC_CAPTURE_BUTTON,
+} adc_capture_trigger;
+
+typedef enum ADC_CAPTURE_STATE {
+    ADC_CAPTURE_IDLE,
+    // Taking the samples to go before the trigger.
+    ADC_CAPTURE_FILLING,
+    ADC_CAPTURE_WAITING,
+    // Taking the samples after the trigger.
+    ADC_CAPTURE_TRIGGERED,
+    // Stopped, with the window ready to be read.
+    ADC_CAPTURE_DONE,
+} adc_capture_state;
+
+// Starts sampling at `rate_hz` with `config`, keeping `pre` samples from
+// before the trigger and `post` from it on. Claims the ADC until the
+// capture is done or stopped, letting other conversions in where they fit
+// between samples, see ADC_SHARE_IN_GAPS in adc.h. Returns false if the
+// timer can't tick at that rate, or the ADC is busy.
+bool adc_capture_start(const adc_config *config, uint32_t rate_hz,
+        uint16_t level, adc_capture_trigger trigger, uint16_t pre,
+        uint16_t post);
+
+// Keeps the rate after the clock has changed, or stops if it can't. See
+// clock.h.
+void adc_capture_clock_changed(void);
+
+// Stops waiting, and forgets what's been captured.
+void adc_capture_stop(void);
+
+adc_capture_state adc_capture_get_state(void);
+
+// Tells once that a capture has been done. Meant for the main loop.
+bool adc_capture_take_done(void);
+
+// The length of the captured window, and where the trigger is within it.
+// Both zero unless it's done.
+uint16_t adc_capture_length(void);
+uint16_t adc_capture_trigger_index(void);
+
+// Copies up to `count` samples of the window, starting from `from`.
+// Returns how many there were.
+uint16_t adc_capture_read(uint16_t from, uint16_t *samples, uint16_t count);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADC_CAPTURE_H */
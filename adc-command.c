@@ -7,116 +7,922 @@
 
 #include "adc-command.h"
 #include "util.h"
+#include "reply.h"
+#include "clock.h"
+#include "adc.h"
+#include "adc-stream.h"
+#include "adc-scan.h"
+#include "adc-watch.h"
+#include "adc-capture.h"
+#include "stats.h"
+#include "filter.h"
+#include "pack.h"
+#include "channel.h"
+#include "vref-command.h"
+#include "protocol.h"
+#include "serial.h"
+#include <inttypes.h>
+#include <stdlib.h>
 #include <avr/io.h>
-#include <string.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 
 static void adc_command_init(void);
-static bool adc_command_execute(char *arglist, const char *arglist_end);
-static void adc_command_print_help_text(void);
+static command_status adc_command_execute(const command_args *args);
+
+// When the ADC can't be had for what's asked. Single conversions only fail
+// like this during WATCH, or if SCAN or CAPTURE never leave them a gap.
+#define BUSY "Busy with SCAN, WATCH or CAPTURE"
+
+enum
+{
+    ADC_FORM_READ,
+    ADC_FORM_CAPTURE,
+    ADC_FORM_DECIMATE,
+    ADC_FORM_DUMP,
+    ADC_FORM_FILTER,
+    ADC_FORM_MV,
+    ADC_FORM_OVERSAMPLE,
+    ADC_FORM_PACK,
+    ADC_FORM_SCAN,
+    ADC_FORM_SET,
+    ADC_FORM_STATS,
+    ADC_FORM_STREAM,
+    ADC_FORM_TABLE,
+    ADC_FORM_WATCH,
+};
+
+static const keyword capture_triggers[] = {
+    { .name = "BUTTON", .value = ADC_CAPTURE_BUTTON, },
+    { .name = "FALLING", .value = ADC_CAPTURE_FALLING, },
+    { .name = "RISING", .value = ADC_CAPTURE_RISING, },
+};
+
+static const keyword capture_states[] = {
+    { .name = "DONE", .value = ADC_CAPTURE_DONE, },
+    { .name = "FILLING", .value = ADC_CAPTURE_FILLING, },
+    { .name = "IDLE", .value = ADC_CAPTURE_IDLE, },
+    { .name = "TRIGGERED", .value = ADC_CAPTURE_TRIGGERED, },
+    { .name = "WAITING", .value = ADC_CAPTURE_WAITING, },
+};
+
+static const keyword filter_kinds[] = {
+    { .name = "AVERAGE", .value = FILTER_AVERAGE, },
+    { .name = "FIR", .value = FILTER_FIR, },
+    { .name = "IIR", .value = FILTER_IIR, },
+    { .name = "NONE", .value = FILTER_NONE, },
+};
+
+static const keyword switch_args[] = {
+    { .name = "OFF", .value = false, },
+    { .name = "ON", .value = true, },
+};
+
+static const keyword watch_modes[] = {
+    { .name = "ABOVE", .value = ADC_WATCH_ABOVE, },
+    { .name = "BELOW", .value = ADC_WATCH_BELOW, },
+    { .name = "INSIDE", .value = ADC_WATCH_INSIDE, },
+    { .name = "OUTSIDE", .value = ADC_WATCH_OUTSIDE, },
+};
+
+static const arg_spec capture_args[] = {
+    ARG_SPEC_INT("level", 0, UINT16_MAX),
+    ARG_SPEC_ENUM(capture_triggers),
+    ARG_SPEC_INT("pre", 0, ADC_CAPTURE_SAMPLES - 1),
+    ARG_SPEC_INT("post", 1, ADC_CAPTURE_SAMPLES),
+    ARG_SPEC_INT("rate_hz", 1, 50000),
+};
+
+static const arg_spec decimate_args[] = {
+    ARG_SPEC_INT("n", 1, UINT8_MAX),
+};
+
+static const arg_spec filter_args[] = {
+    ARG_SPEC_ENUM(filter_kinds),
+    ARG_SPEC_WORD("param"),
+};
+
+static const arg_spec dump_args[] = {
+    ARG_SPEC_INT("from", 0, ADC_CAPTURE_SAMPLES - 1),
+    ARG_SPEC_INT("count", 1, ADC_CAPTURE_SAMPLES),
+};
+
+static const arg_spec oversample_args[] = {
+    ARG_SPEC_INT("n", 1, 64),
+};
+
+static const arg_spec pack_args[] = {
+    ARG_SPEC_ENUM(switch_args),
+};
+
+static const arg_spec scan_args[] = {
+    ARG_SPEC_WORD("inputs"),
+    ARG_SPEC_INT("settle_us", 0, 10000),
+};
+
+static const arg_spec watch_args[] = {
+    ARG_SPEC_INT("low", 0, UINT16_MAX),
+    ARG_SPEC_INT("high", 0, UINT16_MAX),
+    ARG_SPEC_ENUM(watch_modes),
+    ARG_SPEC_INT("hysteresis", 0, 1024),
+};
+
+static const arg_spec set_args[] = {
+    ARG_SPEC_CHANNEL(0, 15),
+};
+
+static const arg_spec stats_args[] = {
+    ARG_SPEC_INT("n", 1, STATS_MAX_COUNT),
+    ARG_SPEC_INT("rate_hz", 1, 50000),
+};
+
+static const arg_spec stream_args[] = {
+    ARG_SPEC_INT("rate_hz", 1, 50000),
+    ARG_SPEC_INT("count", 1, INT32_MAX),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form adc_forms[] = {
+    [ADC_FORM_READ] = {
+        .help = "Prints the value currently being read",
+    },
+    [ADC_FORM_CAPTURE] = {
+        .keyword = "CAPTURE", .args = capture_args,
+        .required = ARRAY_LEN(capture_args), .count = ARRAY_LEN(capture_args),
+        .or_none = true,
+        .help = "Captures samples around a trigger, or shows how it's going",
+    },
+    [ADC_FORM_DECIMATE] = {
+        .keyword = "DECIMATE", .args = decimate_args, .required = 1,
+        .count = 1,
+        .help = "Lets only every nth filtered sample through",
+    },
+    [ADC_FORM_DUMP] = {
+        .keyword = "DUMP", .args = dump_args, .count = 2,
+        .help = "Sends the captured samples, or count of them from from",
+    },
+    [ADC_FORM_FILTER] = {
+        .keyword = "FILTER", .args = filter_args, .count = 2,
+        .help = "Sets IIR <shift>, AVERAGE <n> or FIR <c0,c1,...>, or shows it;"
+                " filters READ, MV, STATS and STREAM only",
+    },
+    [ADC_FORM_MV] = {
+        .keyword = "MV",
+        .help = "Prints the voltage being read in millivolts",
+    },
+    [ADC_FORM_OVERSAMPLE] = {
+        .keyword = "OVERSAMPLE", .args = oversample_args, .required = 1,
+        .count = 1,
+        .help = "Adds up n conversions for each value, n a power of two",
+    },
+    [ADC_FORM_PACK] = {
+        .keyword = "PACK", .args = pack_args, .required = 1, .count = 1,
+        .help = "Sends streamed and dumped samples in packed binary blocks",
+    },
+    [ADC_FORM_SCAN] = {
+        .keyword = "SCAN", .args = scan_args, .count = 2,
+        .help = "Scans inputs like A0,A3 in the background, or stops",
+    },
+    [ADC_FORM_SET] = {
+        .keyword = "SET", .args = set_args, .required = 1, .count = 1,
+        .help = "Sets the input channel",
+    },
+    [ADC_FORM_STATS] = {
+        .keyword = "STATS", .args = stats_args, .required = 1, .count = 2,
+        .help = "Samples n times and prints min, max, mean, stddev and RMS",
+    },
+    [ADC_FORM_STREAM] = {
+        .keyword = "STREAM", .args = stream_args, .required = 1, .count = 2,
+        .help = "Samples continuously until count or a key press",
+    },
+    [ADC_FORM_TABLE] = {
+        .keyword = "TABLE",
+        .help = "Prints the latest values of the inputs being scanned",
+    },
+    [ADC_FORM_WATCH] = {
+        .keyword = "WATCH", .args = watch_args, .required = 2,
+        .count = ARRAY_LEN(watch_args), .or_none = true,
+        .help = "Alerts when the value leaves low..high, or stops",
+    },
+};
 
 const command adc_cmd = {
     .name = "ADC",
     .short_help_blurb = "Reads an analog voltage as digital value",
 
+    .forms = adc_forms,
+    .form_count = ARRAY_LEN(adc_forms),
+
     .init = &adc_command_init,
     .execute = &adc_command_execute,
-    .print_help_text = &adc_command_print_help_text,
-};
-
-#define A(n) { .name = "A"#n, .value = ADC_MUXPOS_AIN ## n ## _gc, }
-static struct
-{
-    const char *name;
-    ADC_MUXPOS_t value;
-} const set_args[] = {
-    A(0),
-    A(1),
-    A(2),
-    A(3),
-    A(4),
-    A(5),
-    A(6),
-    A(7),
-    A(8),
-    A(9),
-    A(10),
-    A(11),
-    A(12),
-    A(13),
-    A(14),
-    A(15),
-};
-#undef A
+};
+
+// How the shell's conversions are set up, by ADC SET and ADC OVERSAMPLE.
+// The reference comes from VREF, and the sampling capacitance with it.
+static adc_config settings = {
+    .muxpos = ADC_MUXPOS_AIN6_gc,
+    .sampnum = ADC_SAMPNUM_ACC1_gc,
+    .initdly = ADC_INITDLY_DLY0_gc,
+};
 
 static void adc_command_init(void)
 {
-    // Make CLK_PER divided by four and use internal voltage reference
-    ADC0.CTRLC = ADC_PRESC_DIV4_gc | ADC_REFSEL_INTREF_gc;
-    // Enable ADC and set the 10-bit mode
-    ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_10BIT_gc;
-    
-    // And set the channel.
-    ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc;
+    adc_init();
+}
+
+static const adc_config *current_settings(void)
+{
+    settings.reference = vref_adc_reference();
+    // Every reference but 0.55 V is above 1 V.
+    settings.sampcap = (settings.reference != VREF_ADC0REFSEL_0V55_gc);
+    return &settings;
+}
+
+// The accumulator adds up 2^n conversions, with n in SAMPNUM.
+static uint8_t oversample_shift(void)
+{
+    return settings.sampnum & ADC_SAMPNUM_gm;
+}
+
+static command_status oversample(uint8_t n)
+{
+    uint8_t shift = 0;
+    while ((1 << shift) < n)
+    {
+        ++shift;
+    }
+    if ((1 << shift) != n)
+    {
+        reply_error("%u isn't a power of two", n);
+        return COMMAND_FAILED;
+    }
+
+    settings.sampnum = shift;
+    return COMMAND_OK;
+}
+
+// Converts a sum of conversions into millivolts, rounding to the nearest.
+// The scale has fraction bits of its own, and dividing by the number of
+// conversions is a shift too.
+static uint16_t millivolts(uint16_t sum)
+{
+    uint8_t shift = VREF_SCALE_BITS + oversample_shift();
+    uint32_t scaled = (uint32_t) sum * vref_adc_scale();
+    return (uint16_t) ((scaled + (1UL << (shift - 1))) >> shift);
+}
+
+void adc_clock_changed(void)
+{
+    ADC0.CTRLC = (ADC0.CTRLC & ~ADC_PRESC_gm) | clock_adc_prescaler();
+    adc_scan_clock_changed();
+    adc_capture_clock_changed();
+}
+
+// Whether to send samples as packed blocks, see ADC PACK.
+static bool packed = false;
+
+#define PACK_TO_DATA "Packed samples go to DATA only, see CHANNEL"
+
+// Packed blocks are binary, so they're refused on the console, where
+// they would only garble the shell.
+static bool pack_fits(channel_producer producer)
+{
+    return channel_get_route(producer) != CHANNEL_CONSOLE;
 }
 
-static bool adc_command_execute(char *arglist, const char *arglist_end)
+// Writes the samples out, packed if asked to, as little-endian 16-bit values
+// in binary, and otherwise as a line of comma-separated numbers.
+static void write_samples(FILE *out, const uint16_t *samples, uint8_t length)
 {
-    char *arg = arglist;
-    // If we got arguments, check if it's a SET command
-    if (iterate_args(&arg, &arglist, arglist_end))
+    if (packed)
     {
-        if (strcasecmp(arg, "SET") != 0) {
-            printf("ADC: Unknown argument: %s\r\n", arg);
-            return false;
+        pack_write(out, samples, length);
+        return;
+    }
+
+    bool binary = reply_get_format() == REPLY_BINARY;
+    for (uint8_t i = 0; i < length; ++i)
+    {
+        if (binary)
+        {
+            putc(samples[i] & 0xFF, out);
+            putc(samples[i] >> 8, out);
         }
-        
-        arg = arglist;
-        // Now check whether we have a required parameter...
-        if (!iterate_args(&arg, &arglist, arglist_end))
+        else
         {
-            printf("ADC: Usage: ADC SET A<n> (0 <= n <= 15)\r\n");
-            return false;
+            fprintf(out, (i == 0) ? "%u" : ",%u", samples[i]);
         }
-        // ...and if we do, check its validity.
-        bool found_port = false;
-        ADC_MUXPOS_t channel;
-        for (size_t i = 0; i < ARRAY_LEN(set_args); ++i)
+    }
+    if (!binary)
+    {
+        fprintf(out, "\r\n");
+    }
+}
+
+// Why samples can't be sent to the console, see `channel_stream`.
+#define NOT_IN_FRAMES "Samples don't fit in a response, route them to DATA"
+
+// Where the samples of the stream are going, see `stream`.
+static FILE *stream_out;
+
+static void send_samples(const uint16_t *samples, uint8_t length)
+{
+    write_samples(stream_out, samples, length);
+}
+
+// Hands the buffers the stream has filled to `use`.
+static void use_ready_samples(void (*use)(const uint16_t *, uint8_t))
+{
+    const uint16_t *samples;
+    uint8_t length;
+    while ((samples = adc_stream_take(&length)) != NULL)
+    {
+        use(samples, length);
+        adc_stream_release();
+    }
+}
+
+// Sleeps until an interrupt, unless there's something to do already.
+static void wait_for_samples(void)
+{
+    uint8_t length;
+    cli();
+    if (adc_stream_running() && (adc_stream_take(&length) == NULL)
+            && !protocol_input_pending())
+    {
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+}
+
+// Samples at `rate_hz` until `count` or a key press, handing each buffer to
+// `use` while the other one fills.
+static bool run_stream(uint32_t rate_hz, uint32_t count,
+        void (*use)(const uint16_t *, uint8_t))
+{
+    if (!adc_stream_start(current_settings(), rate_hz, count))
+    {
+        reply_error("Can't sample at %"PRIu32" Hz at this clock",
+                rate_hz);
+        return false;
+    }
+
+    while (adc_stream_running() && !protocol_input_pending())
+    {
+        use_ready_samples(use);
+        serial_poll();
+        wait_for_samples();
+    }
+    adc_stream_stop();
+    use_ready_samples(use);
+    return true;
+}
+
+static command_status stream(uint32_t rate_hz, uint32_t count)
+{
+    stream_out = channel_stream(CHANNEL_STREAM);
+    if (stream_out == NULL)
+    {
+        reply_error(NOT_IN_FRAMES);
+        return COMMAND_FAILED;
+    }
+    if (packed && !pack_fits(CHANNEL_STREAM))
+    {
+        reply_error(PACK_TO_DATA);
+        return COMMAND_FAILED;
+    }
+    if (!run_stream(rate_hz, count, &send_samples))
+    {
+        return COMMAND_FAILED;
+    }
+
+    adc_stream_stats stats;
+    adc_stream_get_stats(&stats);
+    reply_u32("samples", "Samples", stats.samples);
+    reply_u32("overruns", "Buffer overruns", stats.overruns);
+    reply_u32("missed", "Missed samples", stats.missed);
+    return COMMAND_OK;
+}
+
+static stats sample_stats;
+
+static void add_samples(const uint16_t *samples, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; ++i)
+    {
+        stats_add(&sample_stats, samples[i]);
+    }
+}
+
+// Reduces the samples as they come, so only the results need sending.
+static command_status reduce(uint16_t count, uint32_t rate_hz)
+{
+    stats_init(&sample_stats);
+    if (rate_hz != 0)
+    {
+        if (!run_stream(rate_hz, count, &add_samples))
+        {
+            return COMMAND_FAILED;
+        }
+    }
+    else
+    {
+        // One conversion after another, as fast as the queue goes.
+        filter_reset();
+        while ((sample_stats.count < count) && !protocol_input_pending())
         {
-            if (strcasecmp(set_args[i].name, arg) == 0)
+            uint16_t value;
+            if (!adc_convert(current_settings(), &value))
+            {
+                reply_error(BUSY);
+                return COMMAND_FAILED;
+            }
+            if (filter_apply(value, &value))
             {
-                found_port = true;
-                channel = set_args[i].value;
-                break;
+                stats_add(&sample_stats, value);
             }
         }
-        
-        if (!found_port)
+    }
+
+    stats_result result;
+    stats_finish(&sample_stats, &result);
+    reply_u16("n", "Samples", sample_stats.count);
+    reply_u16("min", "Minimum", result.min);
+    reply_u16("max", "Maximum", result.max);
+    reply_u16("mean", "Mean", result.mean);
+    reply_u32("variance", "Variance", result.variance);
+    reply_u16("stddev", "Standard deviation", result.stddev);
+    reply_u16("rms", "RMS", result.rms);
+    return COMMAND_OK;
+}
+
+static command_status capture(const command_args *args)
+{
+    if (args->count == 0)
+    {
+        reply_keyword("state", "State", capture_states,
+                ARRAY_LEN(capture_states), adc_capture_get_state());
+        reply_u16("samples", "Samples captured", adc_capture_length());
+        reply_u16("trigger", "Trigger at", adc_capture_trigger_index());
+        return COMMAND_OK;
+    }
+
+    uint16_t pre = args->values[2].number;
+    uint16_t post = args->values[3].number;
+    if (pre + post > ADC_CAPTURE_SAMPLES)
+    {
+        reply_error("At most %u samples fit", ADC_CAPTURE_SAMPLES);
+        return COMMAND_FAILED;
+    }
+
+    adc_capture_stop();
+    if (adc_busy())
+    {
+        reply_error(BUSY);
+        return COMMAND_FAILED;
+    }
+    uint32_t rate_hz = args->values[4].number;
+    if (!adc_capture_start(current_settings(), rate_hz,
+            args->values[0].number, args->values[1].number, pre, post))
+    {
+        reply_error("Can't sample at %"PRIu32" Hz at this clock",
+                rate_hz);
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
+
+// Sends the captured window, a buffer's worth at a time like a stream.
+static command_status dump(const command_args *args)
+{
+    uint16_t length = adc_capture_length();
+    if (length == 0)
+    {
+        reply_error("Nothing captured");
+        return COMMAND_FAILED;
+    }
+    uint16_t from = (args->count > 0) ? args->values[0].number : 0;
+    uint16_t count = (args->count > 1) ? args->values[1].number : length;
+
+    FILE *out = channel_stream(CHANNEL_DUMP);
+    if (out == NULL)
+    {
+        reply_error(NOT_IN_FRAMES);
+        return COMMAND_FAILED;
+    }
+    if (packed && !pack_fits(CHANNEL_DUMP))
+    {
+        reply_error(PACK_TO_DATA);
+        return COMMAND_FAILED;
+    }
+    uint16_t samples[ADC_STREAM_BUFFER_SAMPLES];
+    uint16_t sent = 0;
+    while (sent < count)
+    {
+        uint16_t chunk = count - sent;
+        if (chunk > ADC_STREAM_BUFFER_SAMPLES)
+        {
+            chunk = ADC_STREAM_BUFFER_SAMPLES;
+        }
+        chunk = adc_capture_read(from + sent, samples, chunk);
+        if (chunk == 0)
         {
-            printf("ADC: Usage: ADC SET A<n> (0 <= n <= 15)\r\n");
-            return false;
+            break;
         }
-        
-        // Input channel found, now just set it.
-        ADC0.MUXPOS = channel;
+        write_samples(out, samples, (uint8_t) chunk);
+        sent += chunk;
     }
-    else
+
+    reply_u16("samples", "Samples sent", sent);
+    reply_u16("trigger", "Trigger at", adc_capture_trigger_index());
+    return COMMAND_OK;
+}
+
+// Parses a decimal number between `min` and `max` from the start of `text`.
+// Returns where it ended, or NULL if there wasn't one.
+static const char *parse_number(const char *text, int32_t min, int32_t max,
+        int32_t *value)
+{
+    char *end;
+    *value = strtol(text, &end, 10);
+    if ((end == text) || (*value < min) || (*value > max))
     {
-        // Otherwise, just read the current channel and print the value
-        // First, start conversion
-        ADC0.COMMAND = ADC_STCONV_bm;
-        // Wait until it's done
-        while (!(ADC0.INTFLAGS & ADC_RESRDY_bm));
-        // Clear the interrupt flag
-        ADC0.INTFLAGS = ADC_RESRDY_bm;
+        return NULL;
+    }
+    return end;
+}
 
-        // And print the value
-        printf("ADC value: %"PRIu16"\r\n", ADC0.RES);
+static command_status set_fir(const char *list)
+{
+    int16_t taps[FILTER_FIR_TAPS];
+    uint8_t count = 0;
+    while (count < FILTER_FIR_TAPS)
+    {
+        int32_t tap;
+        list = parse_number(list, INT16_MIN, INT16_MAX, &tap);
+        if ((list == NULL) || ((*list != ',') && (*list != '\0')))
+        {
+            reply_error("Coefficient %u isn't a number from %d to %d",
+                    count + 1, INT16_MIN, INT16_MAX);
+            return COMMAND_FAILED;
+        }
+        taps[count++] = (int16_t) tap;
+        if (*list == '\0')
+        {
+            break;
+        }
+        ++list;
+    }
+    if (*list != '\0')
+    {
+        reply_error("At most %u coefficients fit", FILTER_FIR_TAPS);
+        return COMMAND_FAILED;
+    }
+
+    if (!filter_set_fir(taps, count))
+    {
+        reply_error("The coefficients add up to more than 2.0");
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
+
+static command_status filter(const command_args *args)
+{
+    if (args->count == 0)
+    {
+        reply_keyword("filter", "Filter", filter_kinds,
+                ARRAY_LEN(filter_kinds), filter_get_kind());
+        reply_u8("size", "Shift or taps", filter_get_size());
+        reply_u8("decimation", "Decimation", filter_get_decimation());
+        return COMMAND_OK;
+    }
+
+    filter_kind kind = args->values[0].number;
+    if (kind == FILTER_NONE)
+    {
+        filter_set_none();
+        return COMMAND_OK;
+    }
+    if (args->count < 2)
+    {
+        reply_error("%s needs a parameter, see HELP ADC",
+                keyword_name(filter_kinds, ARRAY_LEN(filter_kinds), kind));
+        return COMMAND_FAILED;
+    }
+    const char *param = args->values[1].text;
+    if (kind == FILTER_FIR)
+    {
+        return set_fir(param);
+    }
+
+    int32_t n;
+    if (kind == FILTER_IIR)
+    {
+        const char *end = parse_number(param, 1, FILTER_IIR_MAX_SHIFT, &n);
+        if ((end == NULL) || (*end != '\0'))
+        {
+            reply_error("The shift goes from 1 to %u", FILTER_IIR_MAX_SHIFT);
+            return COMMAND_FAILED;
+        }
+        filter_set_iir((uint8_t) n);
+        return COMMAND_OK;
+    }
+
+    const char *end = parse_number(param, 1, 1 << FILTER_AVERAGE_MAX_SHIFT,
+            &n);
+    if ((end == NULL) || (*end != '\0'))
+    {
+        reply_error("The length goes from 1 to %u",
+                1 << FILTER_AVERAGE_MAX_SHIFT);
+        return COMMAND_FAILED;
+    }
+
+    uint8_t shift = 0;
+    while ((1 << shift) < n)
+    {
+        ++shift;
+    }
+    if ((1 << shift) != n)
+    {
+        reply_error("%"PRId32" isn't a power of two", n);
+        return COMMAND_FAILED;
+    }
+    filter_set_average(shift);
+    return COMMAND_OK;
+}
+
+// Parses a list like `A0,A3,A6`. Returns the number of inputs on it, or
+// zero if it isn't valid.
+static uint8_t parse_channels(const char *list, uint8_t *channels)
+{
+    uint8_t count = 0;
+    uint16_t seen = 0;
+    while (count < ADC_SCAN_MAX_CHANNELS)
+    {
+        if ((*list != 'A') && (*list != 'a'))
+        {
+            return 0;
+        }
+        char *end;
+        long channel = strtol(list + 1, &end, 10);
+        // Each input gets a single entry in the table.
+        if ((end == list + 1) || (channel < 0) || (channel > 15)
+                || (seen & (1U << channel)))
+        {
+            return 0;
+        }
+        seen |= 1U << channel;
+        channels[count++] = (uint8_t) channel;
+
+        if (*end == '\0')
+        {
+            return count;
+        }
+        if (*end != ',')
+        {
+            return 0;
+        }
+        list = end + 1;
+    }
+    return 0;
+}
+
+static command_status scan(const command_args *args)
+{
+    adc_scan_stop();
+    if (args->count == 0)
+    {
+        return COMMAND_OK;
+    }
+
+    uint8_t channels[ADC_SCAN_MAX_CHANNELS];
+    uint8_t count = parse_channels(args->values[0].text, channels);
+    if (count == 0)
+    {
+        reply_error("Inputs are A0..A15, each once, at most %u",
+                ADC_SCAN_MAX_CHANNELS);
+        return COMMAND_FAILED;
+    }
+    uint16_t settle_us = (args->count > 1)
+            ? args->values[1].number : ADC_SCAN_DEFAULT_SETTLE_US;
+    if (adc_busy())
+    {
+        reply_error(BUSY);
+        return COMMAND_FAILED;
+    }
+    if (!adc_scan_start(current_settings(), channels, count, settle_us))
+    {
+        reply_error("Can't settle for %u us at this clock", settle_us);
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
+
+static command_status print_table(void)
+{
+    adc_scan_entry entries[ADC_SCAN_MAX_CHANNELS];
+    uint8_t count = adc_scan_get_table(entries);
+    if (count == 0)
+    {
+        reply_error("Not scanning");
+        return COMMAND_FAILED;
+    }
+
+    // Fits `a15_ticks` and `A15 time (ticks)`.
+    char key[12];
+    char label[20];
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        unsigned channel = entries[i].channel;
+        snprintf(key, sizeof(key), "a%u", channel);
+        snprintf(label, sizeof(label), "A%u value", channel);
+        reply_u16(key, label, entries[i].value);
+        snprintf(key, sizeof(key), "a%u_seq", channel);
+        snprintf(label, sizeof(label), "A%u sequence", channel);
+        reply_u32(key, label, entries[i].sequence);
+        snprintf(key, sizeof(key), "a%u_ticks", channel);
+        snprintf(label, sizeof(label), "A%u time (ticks)", channel);
+        reply_u32(key, label, entries[i].ticks);
+    }
+    return COMMAND_OK;
+}
+
+static command_status watch(const command_args *args)
+{
+    if (args->count == 0)
+    {
+        if (!adc_watch_running())
+        {
+            reply_error("Not watching");
+            return COMMAND_FAILED;
+        }
+        reply_u32("triggers", "Times triggered", adc_watch_stop());
+        return COMMAND_OK;
+    }
+
+    uint16_t low = args->values[0].number;
+    uint16_t high = args->values[1].number;
+    adc_watch_mode mode = (args->count > 2)
+            ? args->values[2].number : ADC_WATCH_OUTSIDE;
+    uint16_t hysteresis = (args->count > 3)
+            ? args->values[3].number : ADC_WATCH_DEFAULT_HYSTERESIS;
+    // Coming back inside needs room for the hysteresis on both sides.
+    if ((low > high) || ((mode == ADC_WATCH_OUTSIDE)
+            && (high - low <= 2 * hysteresis)))
+    {
+        reply_error("The window is too narrow");
+        return COMMAND_FAILED;
+    }
+
+    adc_watch_stop();
+    if (adc_busy())
+    {
+        reply_error(BUSY);
+        return COMMAND_FAILED;
+    }
+    adc_watch_start(current_settings(), low, high, mode, hysteresis);
+    return COMMAND_OK;
+}
+
+void adc_poll(void)
+{
+    adc_watch_alert alert;
+    if (adc_watch_take_alert(&alert))
+    {
+        protocol_begin_event(&adc_cmd);
+        reply_u16("value", "ADC value", alert.value);
+        reply_u16("triggers", "Times triggered", alert.triggers);
+        reply_u32("ticks", "Time (ticks)", alert.ticks);
+        protocol_end_event();
+    }
+
+    // Lets the host know there's a window to dump.
+    if (adc_capture_take_done())
+    {
+        protocol_begin_event(&adc_cmd);
+        reply_u16("captured", "Samples captured", adc_capture_length());
+        reply_u16("trigger", "Trigger at", adc_capture_trigger_index());
+        protocol_end_event();
     }
-    return true;
 }
 
-static void adc_command_print_help_text(void)
+static command_status adc_command_execute(const command_args *args)
 {
-    printf("\tADC\tPrints the value currently being read\r\n");
-    printf("\tADC SET A<n>\tSets the input channel (0 <= n <= 15)\r\n");
-}
\ No newline at end of file
+    if (args->form == ADC_FORM_FILTER)
+    {
+        return filter(args);
+    }
+
+    if (args->form == ADC_FORM_PACK)
+    {
+        bool on = args->values[0].number;
+        if (on && !(pack_fits(CHANNEL_STREAM) && pack_fits(CHANNEL_DUMP)))
+        {
+            reply_error(PACK_TO_DATA);
+            return COMMAND_FAILED;
+        }
+        packed = on;
+        return COMMAND_OK;
+    }
+
+    if (args->form == ADC_FORM_DECIMATE)
+    {
+        filter_set_decimation(args->values[0].number);
+        return COMMAND_OK;
+    }
+
+    if (args->form == ADC_FORM_CAPTURE)
+    {
+        return capture(args);
+    }
+
+    if (args->form == ADC_FORM_DUMP)
+    {
+        return dump(args);
+    }
+
+    if (args->form == ADC_FORM_WATCH)
+    {
+        return watch(args);
+    }
+
+    if (args->form == ADC_FORM_SCAN)
+    {
+        return scan(args);
+    }
+
+    if (args->form == ADC_FORM_TABLE)
+    {
+        return print_table();
+    }
+
+    // The settings apply from the next conversion, stream, scan or watch.
+    if (args->form == ADC_FORM_OVERSAMPLE)
+    {
+        return oversample(args->values[0].number);
+    }
+
+    if (args->form == ADC_FORM_SET)
+    {
+        // The input channels are numbered consecutively.
+        settings.muxpos = ADC_MUXPOS_AIN0_gc
+                + (uint8_t) args->values[0].number;
+        return COMMAND_OK;
+    }
+
+    // Sampling at a rate needs the timer, and the ADC to itself. Single
+    // conversions get queued in between whatever runs in the background.
+    bool timed = (args->form == ADC_FORM_STREAM)
+            || ((args->form == ADC_FORM_STATS) && (args->count > 1));
+    if (timed && adc_busy())
+    {
+        reply_error(BUSY);
+        return COMMAND_FAILED;
+    }
+
+    if (args->form == ADC_FORM_STREAM)
+    {
+        return stream(args->values[0].number,
+                (args->count > 1) ? args->values[1].number : 0);
+    }
+
+    if (args->form == ADC_FORM_STATS)
+    {
+        return reduce(args->values[0].number,
+                (args->count > 1) ? args->values[1].number : 0);
+    }
+    else
+    {
+        // Otherwise, just read the current channel and print the value,
+        // after enough conversions for the filter to settle.
+        uint16_t value;
+        filter_reset();
+        for (uint16_t i = filter_settle_samples(); i > 0; --i)
+        {
+            if (!adc_convert(current_settings(), &value))
+            {
+                reply_error(BUSY);
+                return COMMAND_FAILED;
+            }
+            filter_apply(value, &value);
+        }
+
+        reply_u8("channel", "ADC channel",
+                settings.muxpos - ADC_MUXPOS_AIN0_gc);
+        reply_u8("samples", "Conversions added up",
+                1 << oversample_shift());
+        if (args->form == ADC_FORM_MV)
+        {
+            reply_u16("mv", "Voltage (mV)", millivolts(value));
+        }
+        else
+        {
+            reply_u16("value", "ADC value", value);
+        }
+    }
+    return COMMAND_OK;
+}
@@ -16,6 +16,13 @@ extern "C" {
 
 extern const command adc_cmd;
 
+// Keeps the ADC clock within limits after the CPU clock has changed.
+void adc_clock_changed(void);
+
+// Sends out the alerts of ADC WATCH. Meant to be called from the main loop,
+// which the comparator's interrupt wakes up.
+void adc_poll(void);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,152 @@
+/*
+ * File:   adc-scan.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:10
+ */
+
+#include "adc-scan.h"
+#include "clock.h"
+#include "ticks.h"
+#include <string.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+static adc_scan_entry table[ADC_SCAN_MAX_CHANNELS];
+static uint8_t table_length = 0;
+// The entry being converted.
+static uint8_t current;
+static uint32_t sequence;
+
+static adc_config config;
+static uint16_t settle;
+static bool running = false;
+
+// Sets the timer's period for the current clock. Returns false if it
+// doesn't fit.
+static bool set_period(void)
+{
+    uint32_t cycles_per_ms = clock_hz() / 1000;
+    uint32_t cycles = ((uint32_t) settle * cycles_per_ms + 999) / 1000
+            + adc_conversion_cycles(&config) + ADC_SCAN_MARGIN_CYCLES;
+
+    uint8_t clksel;
+    uint16_t period;
+    if (!clock_tcb_period(cycles, &clksel, &period))
+    {
+        return false;
+    }
+    TCB0.CTRLA = 0;
+    TCB0.CCMP = period;
+    TCB0.CNT = 0;
+    TCB0.CTRLA = clksel | TCB_ENABLE_bm;
+    return true;
+}
+
+static void select_entry(uint8_t entry)
+{
+    adc_select(ADC_MUXPOS_AIN0_gc + table[entry].channel);
+}
+
+static void store_result(uint16_t result)
+{
+    adc_scan_entry *entry = &table[current];
+    entry->value = result;
+    entry->sequence = ++sequence;
+    entry->ticks = ticks_now();
+
+    // Switching right away gives the next input all the time until the
+    // timer's next tick to settle.
+    if (++current == table_length)
+    {
+        current = 0;
+    }
+    select_entry(current);
+}
+
+bool adc_scan_start(const adc_config *scan_config, const uint8_t *channels,
+        uint8_t count, uint16_t settle_us)
+{
+    if ((count == 0) || (count > ADC_SCAN_MAX_CHANNELS))
+    {
+        return false;
+    }
+
+    memset(table, 0, sizeof(table));
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        table[i].channel = channels[i];
+    }
+    table_length = count;
+    current = 0;
+    sequence = 0;
+    settle = settle_us;
+    config = *scan_config;
+
+    // Requests get converted in between, after which the timer starts
+    // over, so the next input still gets all of the settling time.
+    if (!adc_claim(&config, &store_result, ADC_SHARE_DELAYING))
+    {
+        table_length = 0;
+        return false;
+    }
+    select_entry(0);
+
+    // The timer's wrapping around starts each conversion, without an
+    // interrupt of its own.
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.INTCTRL = 0;
+    if (!set_period())
+    {
+        adc_release();
+        table_length = 0;
+        return false;
+    }
+    ADC_EVENT_CHANNEL = EVSYS_GENERATOR_TCB0_CAPT_gc;
+    EVSYS.USERADC0 = ADC_EVENT_USER;
+    ADC0.EVCTRL = ADC_STARTEI_bm;
+    running = true;
+    return true;
+}
+
+void adc_scan_stop(void)
+{
+    if (!running)
+    {
+        return;
+    }
+
+    TCB0.CTRLA = 0;
+    ADC0.EVCTRL = 0;
+    EVSYS.USERADC0 = EVSYS_CHANNEL_OFF_gc;
+    // Let the last conversion finish before anyone else sets the ADC up.
+    while (ADC0.COMMAND & ADC_STCONV_bm);
+    adc_release();
+
+    running = false;
+    table_length = 0;
+}
+
+bool adc_scan_running(void)
+{
+    return running;
+}
+
+uint8_t adc_scan_get_table(adc_scan_entry *entries)
+{
+    uint8_t length;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        length = table_length;
+        memcpy(entries, table, length * sizeof(*entries));
+    }
+    return length;
+}
+
+void adc_scan_clock_changed(void)
+{
+    if (running && !set_period())
+    {
+        adc_scan_stop();
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * File:   adc-scan.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:10
+ */
+
+#ifndef ADC_SCAN_H
+#define	ADC_SCAN_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adc.h"
+
+// Converting a list of inputs round-robin in the background, keeping the
+// latest value of each in a table.
+//
+// TCB0 triggers the conversions through the event system like with
+// streaming, see adc-stream.h. As soon as a result is in, the interrupt
+// switches to the next input, which then has the rest of the timer's period
+// to settle before its conversion starts.
+
+// The most inputs on the list.
+#define ADC_SCAN_MAX_CHANNELS 16
+
+// CPU cycles added to each period for the interrupt to get around to
+// switching the input.
+#ifndef ADC_SCAN_MARGIN_CYCLES
+#define ADC_SCAN_MARGIN_CYCLES 100
+#endif
+
+// How long each input settles when not asked otherwise, in microseconds.
+#ifndef ADC_SCAN_DEFAULT_SETTLE_US
+#define ADC_SCAN_DEFAULT_SETTLE_US 10
+#endif
+
+typedef struct ADC_SCAN_ENTRY {
+    // The input, as in A<n>.
+    uint8_t channel;
+    uint16_t value;
+    // Counts the conversions of all of the inputs, so the newest value has
+    // the highest number. Zero if the input hasn't been converted yet.
+    uint32_t sequence;
+    // When the conversion finished, see ticks.h.
+    uint32_t ticks;
+} adc_scan_entry;
+
+// Starts converting the `count` inputs of `channels` in turn, otherwise set
+// up with `config`, letting each input settle for `settle_us` microseconds
+// first. Claims the ADC until `adc_scan_stop`, converting other requests in
+// between, see ADC_SHARE_DELAYING in adc.h. Returns false if the timer can't
+// fit the settling and the conversion in a period, or the ADC is busy.
+bool adc_scan_start(const adc_config *config, const uint8_t *channels,
+        uint8_t count, uint16_t settle_us);
+
+// Stops, and gives the ADC back.
+void adc_scan_stop(void);
+
+bool adc_scan_running(void);
+
+// Copies the table as it was at a single moment. Returns the number of
+// entries, which is zero if there's no scan.
+uint8_t adc_scan_get_table(adc_scan_entry *entries);
+
+// Fits the period to the new clock, or stops if it can't. See clock.h.
+void adc_scan_clock_changed(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADC_SCAN_H */
@@ -0,0 +1,197 @@
+/*
+ * File:   adc-stream.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 07:30
+ */
+
+#include "adc-stream.h"
+#include "clock.h"
+#include "filter.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+static uint16_t buffers[2][ADC_STREAM_BUFFER_SAMPLES];
+static volatile uint8_t lengths[2];
+// Whether the buffer is waiting to be taken, and the interrupt mustn't
+// touch it.
+static volatile bool full[2];
+// The buffer the interrupt stores into, and the one to be taken next.
+static uint8_t filling;
+static uint8_t taking;
+
+static volatile bool running = false;
+// Samples left to take, or zero for no limit.
+static volatile uint32_t remaining;
+
+static volatile uint32_t ticks;
+// Results, before the filter's decimation.
+static volatile uint32_t conversions;
+static volatile uint32_t samples;
+static volatile uint32_t overruns;
+
+static void store_result(uint16_t result);
+
+bool adc_stream_start(const adc_config *config, uint32_t rate_hz,
+        uint32_t count)
+{
+    uint8_t clksel;
+    uint16_t period;
+    if (!clock_tcb_period((clock_hz() + rate_hz / 2) / rate_hz, &clksel,
+            &period))
+    {
+        return false;
+    }
+    if (!adc_claim(config, &store_result, ADC_EXCLUSIVE))
+    {
+        return false;
+    }
+
+    lengths[0] = lengths[1] = 0;
+    full[0] = full[1] = false;
+    filling = taking = 0;
+    remaining = count;
+    ticks = conversions = samples = overruns = 0;
+    filter_reset();
+    running = true;
+
+    // Each time the timer wraps around, it starts a conversion.
+    ADC_EVENT_CHANNEL = EVSYS_GENERATOR_TCB0_CAPT_gc;
+    EVSYS.USERADC0 = ADC_EVENT_USER;
+    ADC0.EVCTRL = ADC_STARTEI_bm;
+
+    // The timer's interrupt only counts the ticks, for telling how many
+    // samples went missing.
+    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB0.CCMP = period;
+    TCB0.CNT = 0;
+    TCB0.INTFLAGS = TCB_CAPT_bm;
+    TCB0.INTCTRL = TCB_CAPT_bm;
+    TCB0.CTRLA = clksel | TCB_ENABLE_bm;
+    return true;
+}
+
+// Lets the buffer being filled be taken, even if it isn't full.
+static void finish_buffer(void)
+{
+    if ((lengths[filling] > 0) && !full[filling])
+    {
+        full[filling] = true;
+    }
+}
+
+static void store(uint16_t value)
+{
+    if (full[filling])
+    {
+        ++overruns;
+    }
+    else
+    {
+        uint8_t length = lengths[filling];
+        buffers[filling][length] = value;
+        lengths[filling] = ++length;
+        ++samples;
+        if (length == ADC_STREAM_BUFFER_SAMPLES)
+        {
+            full[filling] = true;
+            filling ^= 1;
+        }
+    }
+}
+
+// Stops the hardware. Called with interrupts off.
+static void stop_sampling(void)
+{
+    TCB0.CTRLA = 0;
+    TCB0.INTCTRL = 0;
+    ADC0.EVCTRL = 0;
+    EVSYS.USERADC0 = EVSYS_CHANNEL_OFF_gc;
+    running = false;
+}
+
+void adc_stream_stop(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (running)
+        {
+            stop_sampling();
+        }
+    }
+
+    // A conversion which was already going still counts.
+    while (ADC0.COMMAND & ADC_STCONV_bm);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (ADC0.INTFLAGS & ADC_RESRDY_bm)
+        {
+            store_result(ADC0.RES);
+        }
+        finish_buffer();
+    }
+    adc_release();
+}
+
+bool adc_stream_running(void)
+{
+    return running;
+}
+
+const uint16_t *adc_stream_take(uint8_t *length)
+{
+    if (!full[taking])
+    {
+        return NULL;
+    }
+    *length = lengths[taking];
+    return buffers[taking];
+}
+
+void adc_stream_release(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        lengths[taking] = 0;
+        full[taking] = false;
+    }
+    taking ^= 1;
+}
+
+void adc_stream_get_stats(adc_stream_stats *stats)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats->samples = samples;
+        stats->overruns = overruns;
+        // Every tick gives a result, except that the latest one's
+        // conversion may still be going.
+        uint32_t converting = running ? 1 : 0;
+        stats->missed = (ticks > conversions + converting)
+                ? ticks - conversions - converting : 0;
+    }
+}
+
+ISR(TCB0_INT_vect)
+{
+    TCB0.INTFLAGS = TCB_CAPT_bm;
+    ++ticks;
+}
+
+static void store_result(uint16_t result)
+{
+    ++conversions;
+    uint16_t value;
+    if (!filter_apply(result, &value))
+    {
+        return;
+    }
+    store(value);
+
+    if ((remaining != 0) && (--remaining == 0))
+    {
+        stop_sampling();
+        finish_buffer();
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * File:   adc-stream.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 07:30
+ */
+
+#ifndef ADC_STREAM_H
+#define	ADC_STREAM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adc.h"
+
+// Continuous sampling of the ADC's current channel.
+//
+// TCB0 triggers the conversions through the event system, so the sampling
+// doesn't jitter with whatever the CPU is doing. The results go through the
+// filter stage, see filter.h, and get stored by the interrupt into one of
+// two buffers, while the other one is handed out to be sent.
+
+// Samples in each of the two buffers.
+#ifndef ADC_STREAM_BUFFER_SAMPLES
+#define ADC_STREAM_BUFFER_SAMPLES 32
+#endif
+
+typedef struct ADC_STREAM_STATS {
+    // Samples stored into the buffers.
+    uint32_t samples;
+    // Samples thrown away because neither buffer had been sent yet.
+    uint32_t overruns;
+    // Ticks which didn't give a sample at all, because the previous
+    // conversion was still going, or its result wasn't picked up in time.
+    uint32_t missed;
+} adc_stream_stats;
+
+// Starts sampling at `rate_hz` with `config`, stopping after `count`
+// samples, or not at all if it's zero. Claims the ADC until
+// `adc_stream_stop`, see adc.h.
+// Returns false if the timer can't tick at that rate, or the ADC is busy.
+bool adc_stream_start(const adc_config *config, uint32_t rate_hz,
+        uint32_t count);
+
+// Stops sampling. What's been sampled so far can still be taken.
+void adc_stream_stop(void);
+
+// Whether it's still sampling. False once `count` samples have been taken.
+bool adc_stream_running(void);
+
+// Gives the next full buffer, in order, or NULL if there isn't one yet.
+// After stopping, the last buffer is given even if it isn't full.
+const uint16_t *adc_stream_take(uint8_t *length);
+
+// Gives the buffer from `adc_stream_take` back to be filled again.
+void adc_stream_release(void);
+
+void adc_stream_get_stats(adc_stream_stats *stats);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADC_STREAM_H */
@@ -0,0 +1,169 @@
+/*
+ * File:   adc-watch.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:40
+ */
+
+#include "adc-watch.h"
+#include "ticks.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+// The comparator settings for triggering, and for waiting to be rearmed.
+typedef struct WINDOW {
+    uint8_t mode;
+    uint16_t low;
+    uint16_t high;
+} window;
+
+static window trigger;
+static window rearm;
+static volatile bool armed;
+
+static bool running = false;
+static uint8_t saved_ctrla;
+
+static volatile uint16_t triggers;
+static volatile uint16_t last_value;
+static volatile uint32_t last_ticks;
+static volatile uint32_t total;
+static uint32_t last_alert;
+
+static uint16_t add_clamped(uint16_t a, uint16_t b)
+{
+    return (a > UINT16_MAX - b) ? UINT16_MAX : a + b;
+}
+
+static uint16_t subtract_clamped(uint16_t a, uint16_t b)
+{
+    return (a < b) ? 0 : a - b;
+}
+
+static void set_window(const window *w)
+{
+    // Nothing gets compared with half of the window changed.
+    ADC0.CTRLE = ADC_WINCM_NONE_gc;
+    ADC0.WINLT = w->low;
+    ADC0.WINHT = w->high;
+    ADC0.CTRLE = w->mode;
+}
+
+bool adc_watch_start(const adc_config *config, uint16_t low,
+        uint16_t high, adc_watch_mode mode, uint16_t hysteresis)
+{
+    trigger.low = low;
+    trigger.high = high;
+    // Coming back has to go past the threshold by the hysteresis, which
+    // is the opposite comparison with the window moved.
+    switch (mode)
+    {
+    case ADC_WATCH_ABOVE:
+        trigger.mode = ADC_WINCM_ABOVE_gc;
+        rearm.mode = ADC_WINCM_BELOW_gc;
+        rearm.low = subtract_clamped(high, hysteresis);
+        rearm.high = high;
+        break;
+    case ADC_WATCH_BELOW:
+        trigger.mode = ADC_WINCM_BELOW_gc;
+        rearm.mode = ADC_WINCM_ABOVE_gc;
+        rearm.low = low;
+        rearm.high = add_clamped(low, hysteresis);
+        break;
+    case ADC_WATCH_INSIDE:
+        trigger.mode = ADC_WINCM_INSIDE_gc;
+        rearm.mode = ADC_WINCM_OUTSIDE_gc;
+        rearm.low = subtract_clamped(low, hysteresis);
+        rearm.high = add_clamped(high, hysteresis);
+        break;
+    case ADC_WATCH_OUTSIDE:
+        trigger.mode = ADC_WINCM_OUTSIDE_gc;
+        rearm.mode = ADC_WINCM_INSIDE_gc;
+        rearm.low = add_clamped(low, hysteresis);
+        rearm.high = subtract_clamped(high, hysteresis);
+        break;
+    }
+
+    if (!adc_claim(config, NULL, ADC_EXCLUSIVE))
+    {
+        return false;
+    }
+    triggers = 0;
+    total = 0;
+    // The first alert may go out right away.
+    last_alert = ticks_now() - ADC_WATCH_ALERT_TICKS;
+    armed = true;
+    set_window(&trigger);
+
+    saved_ctrla = ADC0.CTRLA;
+    ADC0.INTFLAGS = ADC_WCMP_bm;
+    ADC0.INTCTRL = ADC_WCMP_bm;
+    ADC0.CTRLA = saved_ctrla | ADC_FREERUN_bm;
+    // Free-running only goes on by itself after the first conversion.
+    ADC0.COMMAND = ADC_STCONV_bm;
+    running = true;
+    return true;
+}
+
+uint32_t adc_watch_stop(void)
+{
+    if (!running)
+    {
+        return 0;
+    }
+
+    ADC0.CTRLA = saved_ctrla;
+    while (ADC0.COMMAND & ADC_STCONV_bm);
+    ADC0.CTRLE = ADC_WINCM_NONE_gc;
+    adc_release();
+    running = false;
+    return total;
+}
+
+bool adc_watch_running(void)
+{
+    return running;
+}
+
+bool adc_watch_take_alert(adc_watch_alert *alert)
+{
+    if (!running || (triggers == 0)
+            || !ticks_passed(last_alert + ADC_WATCH_ALERT_TICKS))
+    {
+        return false;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        alert->triggers = triggers;
+        alert->value = last_value;
+        alert->ticks = last_ticks;
+        triggers = 0;
+    }
+    last_alert = ticks_now();
+    return true;
+}
+
+ISR(ADC0_WCOMP_vect)
+{
+    // Switching first means the flag can only be set again by a result
+    // compared the new way.
+    if (armed)
+    {
+        set_window(&rearm);
+        last_value = ADC0.RES;
+        last_ticks = ticks_now();
+        if (triggers < UINT16_MAX)
+        {
+            ++triggers;
+        }
+        ++total;
+    }
+    else
+    {
+        set_window(&trigger);
+    }
+    armed = !armed;
+    ADC0.INTFLAGS = ADC_WCMP_bm;
+}
@@ -0,0 +1,71 @@
+/*
+ * File:   adc-watch.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:40
+ */
+
+#ifndef ADC_WATCH_H
+#define	ADC_WATCH_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "adc.h"
+
+// Watching the ADC's current channel with the window comparator, so that
+// nothing needs to be done until the value crosses a threshold.
+//
+// The ADC converts free-running, and interrupts only when the comparator
+// matches. Then the comparator is switched to wait for the value to come
+// back, past the threshold by the hysteresis, before it can trigger again.
+
+// What counts as triggering, in terms of the thresholds `low` and `high`.
+typedef enum ADC_WATCH_MODE {
+    ADC_WATCH_ABOVE,
+    ADC_WATCH_BELOW,
+    ADC_WATCH_INSIDE,
+    ADC_WATCH_OUTSIDE,
+} adc_watch_mode;
+
+#ifndef ADC_WATCH_DEFAULT_HYSTERESIS
+#define ADC_WATCH_DEFAULT_HYSTERESIS 8
+#endif
+
+// The least time between alerts, in ticks, see ticks.h. Triggers coming in
+// faster are added up into the next alert.
+#ifndef ADC_WATCH_ALERT_TICKS
+#define ADC_WATCH_ALERT_TICKS (TICKS_PER_SECOND / 4)
+#endif
+
+typedef struct ADC_WATCH_ALERT {
+    // How many times it triggered since the last alert.
+    uint16_t triggers;
+    // The value that triggered it last, and when.
+    uint16_t value;
+    uint32_t ticks;
+} adc_watch_alert;
+
+// Starts watching, with the ADC set up with `config`. Claims the ADC
+// until `adc_watch_stop`, see adc.h. Returns false if the ADC is busy.
+bool adc_watch_start(const adc_config *config, uint16_t low,
+        uint16_t high, adc_watch_mode mode, uint16_t hysteresis);
+
+// Stops, and returns how many times it triggered altogether.
+uint32_t adc_watch_stop(void);
+
+bool adc_watch_running(void);
+
+// Takes what has triggered since the last alert, if it's time for one.
+// Returns false if there's nothing to report yet.
+bool adc_watch_take_alert(adc_watch_alert *alert);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADC_WATCH_H */
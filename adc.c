@@ -0,0 +1,366 @@
+/*
+ * File:   adc.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:10
+ */
+
+#include "adc.h"
+#include "clock.h"
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+static volatile bool claimed = false;
+static volatile adc_handler owner = NULL;
+static adc_sharing owner_sharing;
+// The owner's setup, to be put back after converting a request in between.
+static adc_config owner_config;
+
+// The request being converted is at the head.
+static adc_request *volatile queue_head = NULL;
+static adc_request *queue_tail = NULL;
+// Whether the head of the queue is in the ADC. Always, unless the ADC is
+// claimed, and then only in one of the owner's gaps.
+static volatile bool converting = false;
+
+// What the registers hold, so only the differences need to be written.
+// Whoever claims the ADC may change anything, so it's forgotten on
+// release.
+static adc_config applied;
+static bool applied_valid = false;
+
+void adc_init(void)
+{
+    // Divide CLK_PER to suit the ADC and use internal voltage reference
+    ADC0.CTRLC = clock_adc_prescaler() | ADC_REFSEL_INTREF_gc;
+    // Enable ADC and set the 10-bit mode
+    ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_10BIT_gc;
+}
+
+static void apply(const adc_config *config)
+{
+    if (!applied_valid || (config->muxpos != applied.muxpos))
+    {
+        ADC0.MUXPOS = config->muxpos;
+    }
+    if (!applied_valid || (config->reference != applied.reference))
+    {
+        VREF.CTRLA = (VREF.CTRLA & ~VREF_ADC0REFSEL_gm) | config->reference;
+    }
+    if (!applied_valid || (config->sampnum != applied.sampnum))
+    {
+        ADC0.CTRLB = config->sampnum;
+    }
+    if (!applied_valid || (config->initdly != applied.initdly))
+    {
+        ADC0.CTRLD = config->initdly;
+    }
+    if (!applied_valid || (config->sampcap != applied.sampcap))
+    {
+        // The prescaler is kept up to date by the clock.
+        ADC0.CTRLC = (ADC0.CTRLC & ADC_PRESC_gm) | ADC_REFSEL_INTREF_gc
+                | (config->sampcap ? ADC_SAMPCAP_bm : 0);
+    }
+    applied = *config;
+    applied_valid = true;
+}
+
+uint32_t adc_conversion_cycles(const adc_config *config)
+{
+    // The sampling takes 2 ADC clocks more than SAMPLEN, and a 10-bit
+    // conversion 13 after it, once for each of the conversions the
+    // accumulator adds up.
+    uint32_t adc_clocks = (uint32_t) (15 + (ADC0.SAMPCTRL & ADC_SAMPLEN_gm))
+            << (config->sampnum & ADC_SAMPNUM_gm);
+    // The delay before the first sample goes 16, 32, ... 256 ADC clocks.
+    uint8_t delay = (config->initdly & ADC_INITDLY_gm) >> ADC_INITDLY_gp;
+    if (delay != 0)
+    {
+        adc_clocks += 8U << delay;
+    }
+    // The prescaler divides by 2, 4, ... 256.
+    return adc_clocks << ((ADC0.CTRLC & ADC_PRESC_gm) + 1);
+}
+
+// Starts converting the request at the head of the queue. Called with
+// interrupts off.
+static void start_head(void)
+{
+    apply(&queue_head->config);
+    converting = true;
+    ADC0.INTFLAGS = ADC_RESRDY_bm;
+    ADC0.INTCTRL = ADC_RESRDY_bm;
+    ADC0.COMMAND = ADC_STCONV_bm;
+}
+
+// Starts converting the request at the head of the queue, if there is one.
+// Called with interrupts off.
+static void start_next(void)
+{
+    if (queue_head == NULL)
+    {
+        ADC0.INTCTRL = 0;
+        return;
+    }
+    start_head();
+}
+
+// Takes the request just converted off the queue. Called with interrupts
+// off.
+static adc_request *take_head(void)
+{
+    adc_request *request = queue_head;
+    queue_head = request->next;
+    converting = false;
+    return request;
+}
+
+// Waits out the conversion of the request at the head, and hands it its
+// result without the interrupt. Called with interrupts off.
+static void finish_now(void)
+{
+    // A conversion takes microseconds, and can't stop half-way.
+    while (ADC0.COMMAND & ADC_STCONV_bm);
+    uint16_t result = ADC0.RES;
+    adc_request *request = take_head();
+    request->done(request, result);
+}
+
+// Converts the next request in the gap after one of the owner's results,
+// if the owner shares and there's time. Called from the interrupt.
+static void serve_queued(void)
+{
+    if ((queue_head == NULL) || (owner_sharing == ADC_EXCLUSIVE))
+    {
+        return;
+    }
+
+    if (owner_sharing == ADC_SHARE_IN_GAPS)
+    {
+        uint32_t left = TCB0.CCMP - TCB0.CNT;
+        if ((TCB0.CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKDIV2_gc)
+        {
+            left *= 2;
+        }
+        if (adc_conversion_cycles(&queue_head->config)
+                + ADC_SHARE_MARGIN_CYCLES > left)
+        {
+            // Maybe the request fits in after a later result.
+            return;
+        }
+    }
+    else
+    {
+        // Hold the owner's next conversion off until the request is done.
+        TCB0.CTRLA &= ~TCB_ENABLE_bm;
+    }
+    start_head();
+}
+
+// Puts the owner's setup back after a request converted in between.
+static void give_back(void)
+{
+    apply(&owner_config);
+    ADC0.INTCTRL = (owner != NULL) ? ADC_RESRDY_bm : 0;
+    if (owner_sharing == ADC_SHARE_DELAYING)
+    {
+        TCB0.CNT = 0;
+        TCB0.CTRLA |= TCB_ENABLE_bm;
+    }
+}
+
+void adc_submit(adc_request *request)
+{
+    request->next = NULL;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (queue_head == NULL)
+        {
+            queue_head = request;
+            if (!claimed)
+            {
+                start_next();
+            }
+        }
+        else
+        {
+            queue_tail->next = request;
+        }
+        queue_tail = request;
+    }
+}
+
+// Takes a request which hasn't started converting off the queue. Returns
+// false if it's being converted already. Called with interrupts off.
+static bool cancel(adc_request *request)
+{
+    if (converting && (queue_head == request))
+    {
+        return false;
+    }
+
+    adc_request *previous = NULL;
+    for (adc_request *r = queue_head; r != NULL; r = r->next)
+    {
+        if (r == request)
+        {
+            if (previous == NULL)
+            {
+                queue_head = r->next;
+            }
+            else
+            {
+                previous->next = r->next;
+            }
+            if (queue_tail == r)
+            {
+                queue_tail = previous;
+            }
+            return true;
+        }
+        previous = r;
+    }
+    return false;
+}
+
+static volatile bool converted;
+static uint16_t converted_result;
+
+static void convert_done(adc_request *request, uint16_t result)
+{
+    (void) request;
+    converted_result = result;
+    converted = true;
+}
+
+bool adc_convert(const adc_config *config, uint16_t *result)
+{
+    if (claimed && (owner_sharing == ADC_EXCLUSIVE))
+    {
+        return false;
+    }
+
+    adc_request request = {
+        .config = *config,
+        .done = &convert_done,
+    };
+    converted = false;
+    uint32_t deadline = ticks_now() + ADC_CONVERT_TIMEOUT_TICKS;
+    adc_submit(&request);
+
+    // Idle until the interrupt has been, checking with interrupts off so
+    // it can't come in between the check and going to sleep. The ticks
+    // wake us up at least once a second to check on the deadline.
+    cli();
+    while (!converted)
+    {
+        if (ticks_passed(deadline) && cancel(&request))
+        {
+            sei();
+            return false;
+        }
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    sei();
+
+    *result = converted_result;
+    return true;
+}
+
+bool adc_claim(const adc_config *config, adc_handler handler,
+        adc_sharing sharing)
+{
+    bool success = false;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (!claimed)
+        {
+            // The owner's interrupt mustn't get the result of a request.
+            if (converting)
+            {
+                finish_now();
+            }
+            owner_config = *config;
+            owner_sharing = sharing;
+            apply(config);
+            owner = handler;
+            ADC0.INTFLAGS = ADC_RESRDY_bm;
+            ADC0.INTCTRL = (handler != NULL) ? ADC_RESRDY_bm : 0;
+            claimed = true;
+            success = true;
+        }
+    }
+    return success;
+}
+
+void adc_select(uint8_t muxpos)
+{
+    owner_config.muxpos = muxpos;
+    applied.muxpos = muxpos;
+    ADC0.MUXPOS = muxpos;
+}
+
+void adc_release(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // A request converted in between still gets its result.
+        if (converting)
+        {
+            finish_now();
+        }
+        ADC0.INTCTRL = 0;
+        ADC0.INTFLAGS = ADC_RESRDY_bm | ADC_WCMP_bm;
+        owner = NULL;
+        claimed = false;
+        applied_valid = false;
+        // Whatever was asked for meanwhile.
+        start_next();
+    }
+}
+
+bool adc_busy(void)
+{
+    return claimed;
+}
+
+ISR(ADC0_RESRDY_vect)
+{
+    // Reading the result clears the flag.
+    uint16_t result = ADC0.RES;
+    if (converting)
+    {
+        adc_request *request = take_head();
+        if (claimed)
+        {
+            give_back();
+        }
+        else
+        {
+            start_next();
+        }
+        // Any request the callback queues goes at the end.
+        request->done(request, result);
+        return;
+    }
+
+    if (claimed)
+    {
+        if (owner != NULL)
+        {
+            owner(result);
+        }
+        // The owner may have let go of the ADC by now.
+        if (claimed)
+        {
+            serve_queued();
+        }
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * File:   adc.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 08:10
+ */
+
+#ifndef ADC_H
+#define	ADC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ticks.h"
+
+// The driver of ADC0, which everything converting goes through.
+//
+// Single conversions are queued as requests, each saying how the ADC is to
+// be set up for it. The driver only writes the registers that differ from
+// the previous request, starts the conversion, and calls the request back
+// from the result-ready interrupt before going on to the next one.
+//
+// What converts continuously in the background claims the ADC instead,
+// until it's released. Depending on the claim, requests made meanwhile are
+// converted in between the owner's conversions, or wait for the release.
+
+// The event system channel carrying a timer's ticks to the ADC, for
+// whoever has claimed it to start conversions with.
+#define ADC_EVENT_CHANNEL EVSYS.CHANNEL0
+#define ADC_EVENT_USER EVSYS_CHANNEL_CHANNEL0_gc
+
+// How the ADC is set up for a conversion. The prescaler follows the clock,
+// see clock.h, and the resolution is always 10 bits.
+typedef struct ADC_CONFIG {
+    // ADC_MUXPOS_*
+    uint8_t muxpos;
+    // The internal reference, VREF_ADC0REFSEL_*
+    uint8_t reference;
+    // How many conversions the accumulator adds up, ADC_SAMPNUM_*
+    uint8_t sampnum;
+    // ADC_INITDLY_*
+    uint8_t initdly;
+    // Whether to use the smaller sampling capacitance, which the datasheet
+    // recommends for references above 1 V.
+    bool sampcap;
+} adc_config;
+
+typedef struct ADC_REQUEST adc_request;
+
+struct ADC_REQUEST {
+    adc_config config;
+    // Called from the interrupt once the conversion is done.
+    void (*done)(adc_request *request, uint16_t result);
+    // Links the queue, for the driver only.
+    adc_request *next;
+};
+
+// Called from the interrupt with the result of each conversion, while the
+// ADC is claimed.
+typedef void (*adc_handler)(uint16_t result);
+
+// How a claim lets queued requests in. The claims which share have TCB0
+// start their conversions through ADC_EVENT_CHANNEL, and need a handler,
+// since the requests are converted right after one of the owner's results.
+// The owner's setup is put back after each request.
+typedef enum ADC_SHARING {
+    // Requests wait until the ADC is released, e.g. while it runs freely.
+    ADC_EXCLUSIVE,
+    // A request is converted only if it's done before the timer starts the
+    // owner's next conversion, so the owner keeps its sampling rate.
+    ADC_SHARE_IN_GAPS,
+    // A request is converted right away, and the timer then starts its
+    // period over, so the owner's input gets all of it to settle again.
+    ADC_SHARE_DELAYING,
+} adc_sharing;
+
+// CPU cycles added to the length of a request before it's fitted in a gap,
+// for the interrupts converting it and putting the owner's setup back.
+#ifndef ADC_SHARE_MARGIN_CYCLES
+#define ADC_SHARE_MARGIN_CYCLES 200
+#endif
+
+// How long `adc_convert` waits for a claim to let its request in, in ticks,
+// see ticks.h.
+#ifndef ADC_CONVERT_TIMEOUT_TICKS
+#define ADC_CONVERT_TIMEOUT_TICKS (2 * TICKS_PER_SECOND)
+#endif
+
+// Enables the ADC.
+void adc_init(void);
+
+// Queues a conversion. The request mustn't be touched until it's done.
+void adc_submit(adc_request *request);
+
+// Converts with `config`, sleeping until the result is in. Returns false
+// right away if the ADC is claimed exclusively, and after
+// ADC_CONVERT_TIMEOUT_TICKS if the claim never had a gap long enough. Only
+// for the main loop.
+bool adc_convert(const adc_config *config, uint16_t *result);
+
+// How many CPU cycles a conversion with `config` takes at the current clock.
+uint32_t adc_conversion_cycles(const adc_config *config);
+
+// Sets the ADC up with `config`, and takes it over. A conversion already
+// under way is finished first, and anything else queued waits as `sharing`
+// says. The result-ready interrupt calls `handler`, unless it's NULL.
+// Returns false if someone else has the ADC already.
+bool adc_claim(const adc_config *config, adc_handler handler,
+        adc_sharing sharing);
+
+// Switches the owner's input, so that it stays switched after requests
+// have been converted in between. Only for whoever has claimed the ADC.
+void adc_select(uint8_t muxpos);
+
+// Turns the interrupts off, and gives the ADC back. A result which hasn't
+// been handed out yet is thrown away.
+void adc_release(void);
+
+// Whether someone has claimed the ADC.
+bool adc_busy(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ADC_H */
@@ -0,0 +1,99 @@
+/*
+ * File:   baud-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 03:40
+ */
+
+#include "baud-command.h"
+#include "serial.h"
+#include "reply.h"
+#include "clock.h"
+#include "util.h"
+#include <inttypes.h>
+
+static void baud_command_init(void);
+static command_status baud_command_execute(const command_args *args);
+
+static const arg_spec baud_args[] = {
+    ARG_SPEC_INT("rate", 300, 2000000),
+};
+
+enum
+{
+    BAUD_FORM_CONSOLE,
+    BAUD_FORM_DATA,
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form baud_forms[] = {
+    [BAUD_FORM_CONSOLE] = {
+        .args = baud_args, .count = 1,
+        .help = "Prints or changes the baud rate, switching after the OK",
+    },
+    [BAUD_FORM_DATA] = {
+        .keyword = "DATA", .args = baud_args, .count = 1,
+        .help = "Prints or changes the baud rate of the data port",
+    },
+};
+
+const command baud_cmd = {
+    .name = "BAUD",
+    .short_help_blurb = "Displays and sets the serial baud rate",
+
+    .forms = baud_forms,
+    .form_count = ARRAY_LEN(baud_forms),
+
+    .init = &baud_command_init,
+    .execute = &baud_command_execute,
+};
+
+static void baud_command_init(void)
+{
+}
+
+static void report(const serial_baud *baud)
+{
+    reply_u32("rate", "Baud rate", baud->rate);
+    reply_u32("actual", "Actual baud rate", baud->actual);
+    reply_i16("error", "Error (0.01 %)", baud->error);
+    reply_bool("clk2x", "Double speed", baud->double_speed);
+}
+
+static command_status baud_command_execute(const command_args *args)
+{
+    serial_port *port = (args->form == BAUD_FORM_DATA)
+            ? serial_data : serial_console;
+    if (port == NULL)
+    {
+        reply_error("There's no data port");
+        return COMMAND_FAILED;
+    }
+
+    serial_baud baud;
+    if (args->count == 0)
+    {
+        serial_get_baud(port, &baud);
+        report(&baud);
+        return COMMAND_OK;
+    }
+
+    bool ok = serial_compute_baud(args->values[0].number, clock_hz(),
+            &baud);
+    if (baud.actual == 0)
+    {
+        reply_error("%"PRId32" is out of reach", args->values[0].number);
+        return COMMAND_FAILED;
+    }
+
+    report(&baud);
+    if (!ok)
+    {
+        reply_error("Off by more than %d.%02d %%",
+                SERIAL_BAUD_TOLERANCE / 100, SERIAL_BAUD_TOLERANCE % 100);
+        return COMMAND_FAILED;
+    }
+
+    serial_request_baud(port, &baud);
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   baud-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 03:40
+ */
+
+#ifndef BAUD_COMMAND_H
+#define	BAUD_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command baud_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BAUD_COMMAND_H */
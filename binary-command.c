@@ -0,0 +1,43 @@
+/*
+ * File:   binary-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:50
+ */
+
+#include "binary-command.h"
+#include "protocol.h"
+#include "util.h"
+
+static void binary_command_init(void);
+static command_status binary_command_execute(const command_args *args);
+
+static const command_form binary_forms[] = {
+    {
+        .help = "Switches to the binary protocol, see protocol.h",
+    },
+};
+
+const command binary_cmd = {
+    .name = "BINARY",
+    .short_help_blurb = "Switches to the binary protocol",
+
+    .forms = binary_forms,
+    .form_count = ARRAY_LEN(binary_forms),
+
+    .init = &binary_command_init,
+    .execute = &binary_command_execute,
+};
+
+static void binary_command_init(void)
+{
+}
+
+static command_status binary_command_execute(const command_args *args)
+{
+    (void) args;
+
+    // Takes effect after the OK, which is the last thing sent as text.
+    protocol_enter_binary();
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   binary-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:50
+ */
+
+#ifndef BINARY_COMMAND_H
+#define	BINARY_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command binary_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BINARY_COMMAND_H */
@@ -6,103 +6,92 @@
  */
 
 #include <avr/io.h>
-#include <string.h>
 #include "button-command.h"
 #include "util.h"
+#include "reply.h"
 
 static void button_command_init(void);
-static bool button_command_execute(char *arglist, const char *arglist_end);
-static void button_command_print_help_text(void);
+static command_status button_command_execute(const command_args *args);
+
+enum
+{
+    BUTTON_FORM_SHOW,
+    BUTTON_FORM_INV,
+    BUTTON_FORM_PUP,
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form button_forms[] = {
+    [BUTTON_FORM_SHOW] = {
+        .help = "Prints the status of the button",
+    },
+    [BUTTON_FORM_INV] = {
+        .keyword = "INV", .args = &arg_on_off, .required = 1, .count = 1,
+        .help = "Configures whether inversion is on",
+    },
+    [BUTTON_FORM_PUP] = {
+        .keyword = "PUP", .args = &arg_on_off, .required = 1, .count = 1,
+        .help = "Configures pull-up resistor",
+    },
+};
 
 const command button_cmd = {
     .name = "BUTTON",
     .short_help_blurb = "Displays configures the push button",
 
+    .forms = button_forms,
+    .form_count = ARRAY_LEN(button_forms),
+
     .init = &button_command_init,
     .execute = &button_command_execute,
-    .print_help_text = &button_command_print_help_text,
 };
 
 static void button_command_init(void)
 {
     // Alright, first make the button act as an input.
-    PORTF.DIRCLR = PIN6_bm;
+    VPORTF.DIR &= ~PIN6_bm;
 }
 
-static bool button_command_execute(char *arglist, const char *arglist_end)
+static command_status button_command_execute(const command_args *args)
 {
-    char *arg = arglist;
-    // If we got arguments, check if it's a INV or PUP command
-    if (iterate_args(&arg, &arglist, arglist_end))
-    {
-        if (!((strcasecmp(arg, "INV") == 0) || (strcasecmp(arg, "PUP") == 0)))
-        {
-            printf("BUTTON: Unknown argument: %s\r\n", arg);
-            return false;
-        }
+    // Both INV and PUP share an argument of either "ON" or "OFF".
+    bool is_on = (args->count > 0) && args->values[0].number;
 
-        // Now it has to either be INV or PUP
-        bool is_invert = strcasecmp(arg, "INV") == 0;
-
-        arg = arglist;
-        if (!iterate_args(&arg, &arglist, arglist_end))
+    switch (args->form)
+    {
+    case BUTTON_FORM_INV:
+        // Set the inverter
+        if (is_on)
         {
-            // In this case, we didn't get a required argument.
-            printf("BUTTON: Usage: BUTTON %s [ON|OFF]\r\n",
-                   is_invert ? "INV" : "PUP");
-            return false;
+            PORTF.PIN6CTRL |= PORT_INVEN_bm;
         }
-        // Both INV and PUP share an argument of either "ON" or "OFF".
-        if (!((strcasecmp(arg, "ON") == 0) || (strcasecmp(arg, "OFF") == 0)))
+        else
         {
-            printf("BUTTON: Usage: BUTTON %s [ON|OFF]\r\n",
-                   is_invert ? "INV" : "PUP");
-            return false;
+            PORTF.PIN6CTRL &= ~PORT_INVEN_bm;
         }
-
-        bool is_on = strcasecmp(arg, "ON");
-
-        if (is_invert)
+        break;
+    case BUTTON_FORM_PUP:
+        // Set the pull-up resistor
+        if (is_on)
         {
-            // Set the inverter
-            if (is_on)
-            {
-                PORTF.PIN6CTRL &= ~PORT_INVEN_bm;
-            }
-            else
-            {
-                PORTF.PIN6CTRL |= PORT_INVEN_bm;
-            }
+            PORTF.PIN6CTRL |= PORT_PULLUPEN_bm;
         }
         else
         {
-            // Set the pull-up resistor
-            if (is_on)
-            {
-                PORTF.PIN6CTRL &= ~PORT_PULLUPEN_bm;
-            }
-            else
-            {
-                PORTF.PIN6CTRL |= PORT_PULLUPEN_bm;
-            }
+            PORTF.PIN6CTRL &= ~PORT_PULLUPEN_bm;
         }
-    }
-    else
+        break;
+    default:
     {
-        bool button = PORTF.IN & PIN6_bm;
+        bool button = VPORTF.IN & PIN6_bm;
         bool invert_on = (PORTF.PIN6CTRL & PORT_INVEN_bm) != 0;
         bool pullup_on = (PORTF.PIN6CTRL & PORT_PULLUPEN_bm) != 0;
 
-        printf("Button logical state: %d\r\n", button ? 1 : 0);
-        printf("State invert: %s\r\n", invert_on ? "ON" : "OFF");
-        printf("Pull-up resistor: %s\r\n", pullup_on ? "ON" : "OFF");
+        reply_u8("state", "Button logical state", button ? 1 : 0);
+        reply_bool("invert", "State invert", invert_on);
+        reply_bool("pullup", "Pull-up resistor", pullup_on);
+        break;
+    }
     }
-    return true;
+    return COMMAND_OK;
 }
-
-static void button_command_print_help_text(void)
-{
-    printf("\tBUTTON\tPrints the status of the button\r\n");
-    printf("\tBUTTON INV [ON|OFF]\tConfigures whether inversion is on\r\n");
-    printf("\tBUTTON PUP [ON|OFF]\tConfigures pull-up resistor\r\n");
-}
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*
+ * File:   channel-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 05:35
+ */
+
+#include "channel-command.h"
+#include "channel.h"
+#include "serial.h"
+#include "reply.h"
+#include "util.h"
+
+static void channel_command_init(void);
+static command_status channel_command_execute(const command_args *args);
+
+// Sorted by name, see `keyword_lookup`.
+static const keyword producer_args[] = {
+    { .name = "DUMP", .value = CHANNEL_DUMP, },
+    { .name = "STREAM", .value = CHANNEL_STREAM, },
+};
+
+// By `channel_producer`, for the machine-readable formats.
+static const char *const producer_keys[] = {
+    "stream",
+    "dump",
+};
+
+static const keyword sink_args[] = {
+    { .name = "CONSOLE", .value = CHANNEL_CONSOLE, },
+    { .name = "DATA", .value = CHANNEL_DATA, },
+    { .name = "NONE", .value = CHANNEL_NONE, },
+};
+
+static const arg_spec channel_args[] = {
+    ARG_SPEC_ENUM(producer_args),
+    ARG_SPEC_ENUM(sink_args),
+};
+
+static const command_form channel_forms[] = {
+    {
+        .args = channel_args, .count = 2,
+        .help = "Prints where bulk output goes, or sends it elsewhere",
+    },
+};
+
+const command channel_cmd = {
+    .name = "CHANNEL",
+    .short_help_blurb = "Routes bulk output to the console or data port",
+
+    .forms = channel_forms,
+    .form_count = ARRAY_LEN(channel_forms),
+
+    .init = &channel_command_init,
+    .execute = &channel_command_execute,
+};
+
+static void channel_command_init(void)
+{
+}
+
+static void report_route(channel_producer producer)
+{
+    const char *name = keyword_name(producer_args, ARRAY_LEN(producer_args),
+            producer);
+    reply_keyword(producer_keys[producer], name, sink_args,
+            ARRAY_LEN(sink_args), channel_get_route(producer));
+}
+
+static command_status channel_command_execute(const command_args *args)
+{
+    if (args->count == 2)
+    {
+        if (!channel_route(args->values[0].number, args->values[1].number))
+        {
+            reply_error("There's no data port");
+            return COMMAND_FAILED;
+        }
+        return COMMAND_OK;
+    }
+    if (args->count == 1)
+    {
+        report_route(args->values[0].number);
+        return COMMAND_OK;
+    }
+
+    for (uint8_t i = 0; i < CHANNEL_PRODUCER_COUNT; ++i)
+    {
+        report_route(i);
+    }
+    if (serial_data != NULL)
+    {
+        serial_tx_stats stats;
+        serial_get_tx_stats(serial_data, &stats);
+        reply_u32("dropped", "DATA bytes dropped", stats.dropped);
+        reply_u32("blocked", "DATA bytes blocked", stats.blocked);
+    }
+    return COMMAND_OK;
+}
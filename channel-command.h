@@ -0,0 +1,23 @@
+/*
+ * File:   channel-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 05:35
+ */
+
+#ifndef CHANNEL_COMMAND_H
+#define	CHANNEL_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command channel_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CHANNEL_COMMAND_H */
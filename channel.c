@@ -0,0 +1,42 @@
+/*
+ * File:   channel.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 05:20
+ */
+
+#include "channel.h"
+#include "protocol.h"
+#include "serial.h"
+#include "util.h"
+
+static channel_sink routes[CHANNEL_PRODUCER_COUNT] = { CHANNEL_CONSOLE, };
+
+bool channel_route(channel_producer producer, channel_sink sink)
+{
+    if ((sink == CHANNEL_DATA) && (serial_data == NULL))
+    {
+        return false;
+    }
+    routes[producer] = sink;
+    return true;
+}
+
+channel_sink channel_get_route(channel_producer producer)
+{
+    return routes[producer];
+}
+
+FILE *channel_stream(channel_producer producer)
+{
+    switch (routes[producer])
+    {
+    case CHANNEL_DATA:
+        return serial_stream(serial_data);
+    case CHANNEL_NONE:
+        return null_stream();
+    case CHANNEL_CONSOLE:
+    default:
+        return protocol_is_binary() ? NULL : stdout;
+    }
+}
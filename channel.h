@@ -0,0 +1,51 @@
+/*
+ * File:   channel.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 05:20
+ */
+
+#ifndef CHANNEL_H
+#define	CHANNEL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Things producing bulk output, which can be sent somewhere other than the
+// console so they don't hold the shell up.
+typedef enum CHANNEL_PRODUCER {
+    // Continuous streams of samples.
+    CHANNEL_STREAM,
+    // Dumps of captured data and logs.
+    CHANNEL_DUMP,
+    CHANNEL_PRODUCER_COUNT,
+} channel_producer;
+
+typedef enum CHANNEL_SINK {
+    // Wherever the shell's output goes.
+    CHANNEL_CONSOLE,
+    // The data port, see SERIAL_DATA_ENABLE.
+    CHANNEL_DATA,
+    // Nowhere.
+    CHANNEL_NONE,
+} channel_sink;
+
+// Sends the output of `producer` to `sink`. Returns false if there is no
+// such sink in this build. Everything goes to the console by default.
+bool channel_route(channel_producer producer, channel_sink sink);
+channel_sink channel_get_route(channel_producer producer);
+
+// Where the producer should write its output right now. NULL if that's the
+// console while it speaks the binary protocol, since each response goes out
+// as a single frame, which bulk output would only overflow.
+FILE *channel_stream(channel_producer producer);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CHANNEL_H */
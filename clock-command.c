@@ -0,0 +1,82 @@
+/*
+ * File:   clock-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 04:40
+ */
+
+#include "clock-command.h"
+#include "clock.h"
+#include "serial.h"
+#include "reply.h"
+#include "util.h"
+#include <inttypes.h>
+
+static void clock_command_init(void);
+static command_status clock_command_execute(const command_args *args);
+
+static const arg_spec clock_args[] = {
+    ARG_SPEC_INT("div", 1, 64),
+};
+
+static const command_form clock_forms[] = {
+    {
+        .args = clock_args, .count = 1,
+        .help = "Prints or sets what the 16/20 MHz oscillator is divided by",
+    },
+};
+
+const command clock_cmd = {
+    .name = "CLOCK",
+    .short_help_blurb = "Displays and sets the CPU clock",
+
+    .forms = clock_forms,
+    .form_count = ARRAY_LEN(clock_forms),
+
+    .init = &clock_command_init,
+    .execute = &clock_command_execute,
+};
+
+static void clock_command_init(void)
+{
+}
+
+static command_status clock_command_execute(const command_args *args)
+{
+    if (args->count > 0)
+    {
+        uint8_t division = args->values[0].number;
+        uint32_t hz = clock_hz_for(division);
+        if (hz == 0)
+        {
+            reply_error("Can't divide by %"PRIu8", only by 1, 2, 4, 6, 8, "
+                    "10, 12, 16, 24, 32, 48 or 64", division);
+            return COMMAND_BAD_ARGUMENTS;
+        }
+
+        // Don't pull the rug from under the other end.
+        serial_port *const ports[] = { serial_console, serial_data, };
+        for (uint8_t i = 0; i < ARRAY_LEN(ports); ++i)
+        {
+            serial_baud current;
+            serial_baud baud;
+            if (ports[i] == NULL)
+            {
+                continue;
+            }
+            serial_get_baud(ports[i], &current);
+            if (!serial_compute_baud(current.rate, hz, &baud))
+            {
+                reply_error("%"PRIu32" baud isn't possible at %"PRIu32
+                        " Hz", current.rate, hz);
+                return COMMAND_FAILED;
+            }
+        }
+
+        clock_set_division(division);
+    }
+
+    reply_u8("div", "Clock division", clock_division());
+    reply_u32("hz", "Clock frequency (Hz)", clock_hz());
+    return COMMAND_OK;
+}
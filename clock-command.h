@@ -0,0 +1,23 @@
+/*
+ * File:   clock-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 04:40
+ */
+
+#ifndef CLOCK_COMMAND_H
+#define	CLOCK_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command clock_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CLOCK_COMMAND_H */
@@ -0,0 +1,157 @@
+/*
+ * File:   clock.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 04:15
+ */
+
+#include "clock.h"
+#include "serial.h"
+#include "led-command.h"
+#include "adc-command.h"
+#include "pwm.h"
+#include "util.h"
+#include <avr/io.h>
+#include <util/atomic.h>
+
+// Everything whose timing depends on the clock, told after it changes.
+static void (*const clock_listeners[])(void) = {
+    &serial_clock_changed,
+    &led_clock_changed,
+    &adc_clock_changed,
+    &pwm_clock_changed,
+};
+
+// The divisions the prescaler supports, and their group configurations.
+// Dividing by one means turning the prescaler off.
+static const struct
+{
+    uint8_t division;
+    uint8_t config;
+} divisions[] = {
+    { 1, 0, },
+    { 2, CLKCTRL_PDIV_2X_gc | CLKCTRL_PEN_bm, },
+    { 4, CLKCTRL_PDIV_4X_gc | CLKCTRL_PEN_bm, },
+    { 6, CLKCTRL_PDIV_6X_gc | CLKCTRL_PEN_bm, },
+    { 8, CLKCTRL_PDIV_8X_gc | CLKCTRL_PEN_bm, },
+    { 10, CLKCTRL_PDIV_10X_gc | CLKCTRL_PEN_bm, },
+    { 12, CLKCTRL_PDIV_12X_gc | CLKCTRL_PEN_bm, },
+    { 16, CLKCTRL_PDIV_16X_gc | CLKCTRL_PEN_bm, },
+    { 24, CLKCTRL_PDIV_24X_gc | CLKCTRL_PEN_bm, },
+    { 32, CLKCTRL_PDIV_32X_gc | CLKCTRL_PEN_bm, },
+    { 48, CLKCTRL_PDIV_48X_gc | CLKCTRL_PEN_bm, },
+    { 64, CLKCTRL_PDIV_64X_gc | CLKCTRL_PEN_bm, },
+};
+
+static uint32_t oscillator_hz = 20000000UL;
+static uint8_t current_division = 6;
+static uint32_t current_hz = 20000000UL / 6;
+
+void clock_init(void)
+{
+    // The internal oscillator runs at either 16 or 20 MHz, chosen by a fuse.
+    if ((FUSE.OSCCFG & FUSE_FREQSEL_gm) == FUSE_FREQSEL_16MHZ_gc)
+    {
+        oscillator_hz = 16000000UL;
+    }
+
+    uint8_t config = CLKCTRL.MCLKCTRLB;
+    if (!(config & CLKCTRL_PEN_bm))
+    {
+        config = 0;
+    }
+    for (uint8_t i = 0; i < ARRAY_LEN(divisions); ++i)
+    {
+        if (divisions[i].config == config)
+        {
+            current_division = divisions[i].division;
+        }
+    }
+    current_hz = oscillator_hz / current_division;
+}
+
+uint32_t clock_hz(void)
+{
+    return current_hz;
+}
+
+uint8_t clock_division(void)
+{
+    return current_division;
+}
+
+static int8_t find_division(uint8_t division)
+{
+    for (uint8_t i = 0; i < ARRAY_LEN(divisions); ++i)
+    {
+        if (divisions[i].division == division)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t clock_hz_for(uint8_t division)
+{
+    return (find_division(division) < 0) ? 0 : oscillator_hz / division;
+}
+
+bool clock_set_division(uint8_t division)
+{
+    int8_t i = find_division(division);
+    if (i < 0)
+    {
+        return false;
+    }
+
+    // Whatever is on its way out was timed for the old clock.
+    serial_flush_all();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, divisions[i].config);
+        current_division = division;
+        current_hz = oscillator_hz / division;
+
+        for (uint8_t k = 0; k < ARRAY_LEN(clock_listeners); ++k)
+        {
+            clock_listeners[k]();
+        }
+    }
+    return true;
+}
+
+uint8_t clock_adc_prescaler(void)
+{
+    // The group configurations go from dividing by 2 to dividing by 256.
+    uint8_t prescaler = ADC_PRESC_DIV2_gc;
+    uint32_t adc_hz = current_hz / 2;
+    while ((adc_hz > CLOCK_ADC_MAX_HZ) && (prescaler < ADC_PRESC_DIV256_gc))
+    {
+        ++prescaler;
+        adc_hz /= 2;
+    }
+    return prescaler;
+}
+
+uint32_t clock_adc_hz(void)
+{
+    return current_hz >> (clock_adc_prescaler() + 1);
+}
+
+bool clock_tcb_period(uint32_t cycles, uint8_t *clksel, uint16_t *ccmp)
+{
+    *clksel = TCB_CLKSEL_CLKDIV1_gc;
+    if (cycles > 0x10000UL)
+    {
+        cycles = (cycles + 1) / 2;
+        *clksel = TCB_CLKSEL_CLKDIV2_gc;
+    }
+    if ((cycles < 2) || (cycles > 0x10000UL))
+    {
+        return false;
+    }
+    *ccmp = (uint16_t) (cycles - 1);
+    return true;
+}
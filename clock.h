@@ -0,0 +1,55 @@
+/*
+ * File:   clock.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 04:15
+ */
+
+#ifndef CLOCK_H
+#define	CLOCK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The ADC is kept at or below this, by choosing its prescaler according to
+// the CPU clock.
+#ifndef CLOCK_ADC_MAX_HZ
+#define CLOCK_ADC_MAX_HZ 1000000UL
+#endif
+
+// Works out the current clock from the oscillator fuses and the prescaler.
+// Leaves the prescaler as it was at reset, at 1/6.
+void clock_init(void);
+
+// The CPU and peripheral clock.
+uint32_t clock_hz(void);
+// What the internal oscillator gets divided by to get it.
+uint8_t clock_division(void);
+
+// The clock that would result from dividing the oscillator by `division`.
+// Returns 0 if the prescaler can't divide by it.
+uint32_t clock_hz_for(uint8_t division);
+
+// Switches the prescaler to divide by `division`, once everything printed
+// so far has been sent. Then tells everything with clock dependent timing,
+// see `clock_listeners`. Returns false if it can't divide by that.
+bool clock_set_division(uint8_t division);
+
+// The ADC prescaler group configuration to use at the current clock.
+uint8_t clock_adc_prescaler(void);
+// The ADC clock that prescaler gives.
+uint32_t clock_adc_hz(void);
+
+// Picks the clock and compare value for a TCB in periodic interrupt mode to
+// wrap around every `cycles` CPU cycles. Returns false if it can't.
+bool clock_tcb_period(uint32_t cycles, uint8_t *clksel, uint16_t *ccmp);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CLOCK_H */
@@ -0,0 +1,109 @@
+/*
+ * File:   cobs.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 00:40
+ */
+
+#include "cobs.h"
+
+void cobs_write(const uint8_t *data, size_t length, FILE *stream)
+{
+    size_t i = 0;
+    while (true)
+    {
+        // Each block is a code byte telling how far the next zero is,
+        // followed by the data up to it. A block of 254 bytes has no zero
+        // after it.
+        size_t run = 0;
+        while ((i + run < length) && (data[i + run] != 0) && (run < 254))
+        {
+            ++run;
+        }
+
+        putc((char) (run + 1), stream);
+        for (size_t k = 0; k < run; ++k)
+        {
+            putc((char) data[i + k], stream);
+        }
+        i += run;
+
+        if (i == length)
+        {
+            break;
+        }
+        if (run < 254)
+        {
+            // Skip the zero the block stood for. If that was the last byte,
+            // an empty block still has to follow for it.
+            ++i;
+        }
+    }
+
+    putc('\0', stream);
+}
+
+void cobs_decoder_init(cobs_decoder *decoder, uint8_t *buffer, size_t size)
+{
+    decoder->buffer = buffer;
+    decoder->size = size;
+    decoder->length = 0;
+    decoder->code = 0;
+    decoder->remaining = 0;
+    decoder->overflow = false;
+}
+
+static void append(cobs_decoder *decoder, uint8_t byte)
+{
+    if (decoder->length < decoder->size)
+    {
+        decoder->buffer[decoder->length++] = byte;
+    }
+    else
+    {
+        decoder->overflow = true;
+    }
+}
+
+cobs_status cobs_decode(cobs_decoder *decoder, uint8_t byte)
+{
+    if (byte == 0)
+    {
+        bool started = decoder->code != 0;
+        bool broken = (decoder->remaining != 0) || decoder->overflow;
+
+        decoder->code = 0;
+        decoder->remaining = 0;
+        decoder->overflow = false;
+        if (!started)
+        {
+            decoder->length = 0;
+            return COBS_MORE;
+        }
+        return broken ? COBS_ERROR : COBS_FRAME;
+    }
+
+    if (decoder->code == 0)
+    {
+        // First byte of a new frame.
+        decoder->length = 0;
+    }
+
+    if (decoder->remaining > 0)
+    {
+        append(decoder, byte);
+        --decoder->remaining;
+    }
+    else
+    {
+        // A new block. The previous one stood for a zero, unless it was a
+        // full one.
+        if ((decoder->code != 0) && (decoder->code != 0xFF))
+        {
+            append(decoder, 0);
+        }
+        decoder->code = byte;
+        decoder->remaining = byte - 1;
+    }
+    return COBS_MORE;
+}
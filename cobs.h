@@ -0,0 +1,60 @@
+/*
+ * File:   cobs.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 00:40
+ */
+
+#ifndef COBS_H
+#define	COBS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Consistent Overhead Byte Stuffing. Encodes a frame so that it contains no
+// zero bytes, which leaves zero free to mark where frames end. A receiver
+// that loses track can always pick up again at the next zero. The overhead
+// is one byte, plus one for every 254 bytes of data.
+
+// Writes `data` encoded to `stream`, followed by the terminating zero.
+void cobs_write(const uint8_t *data, size_t length, FILE *stream);
+
+typedef enum COBS_STATUS {
+    // Nothing finished yet, keep feeding.
+    COBS_MORE,
+    // A whole frame has been decoded.
+    COBS_FRAME,
+    // The frame ended early or didn't fit the buffer, and was thrown away.
+    COBS_ERROR,
+} cobs_status;
+
+// Decodes a frame a byte at a time into `buffer`.
+typedef struct COBS_DECODER {
+    uint8_t *buffer;
+    size_t size;
+    size_t length;
+    // The code byte of the block being decoded, zero between frames.
+    uint8_t code;
+    // Data bytes left in the block.
+    uint8_t remaining;
+    bool overflow;
+} cobs_decoder;
+
+void cobs_decoder_init(cobs_decoder *decoder, uint8_t *buffer, size_t size);
+
+// Feeds the next received byte. Once it returns COBS_FRAME, the frame is in
+// the buffer and `length` bytes long, until the next byte gets fed. Empty
+// frames, as from repeated zeros, are skipped.
+cobs_status cobs_decode(cobs_decoder *decoder, uint8_t byte);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* COBS_H */
@@ -6,28 +6,363 @@
  */
 
 #include "command.h"
+#include "keyword.h"
+#include "pin.h"
+#include "reply.h"
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <ctype.h>
+#include <inttypes.h>
 
+#include "baud-command.h"
+#include "binary-command.h"
+#include "format-command.h"
 #include "reset-command.h"
 #include "help-command.h"
 #include "vref-command.h"
 #include "adc-command.h"
 #include "temp-command.h"
 #include "button-command.h"
+#include "channel-command.h"
+#include "clock-command.h"
+#include "gpio-command.h"
 #include "led-command.h"
+#include "serial-command.h"
+#include "pwm-command.h"
 
+// Kept sorted by name, so `command_find` can do a binary search on it.
 const command *commands[] = {
-    &reset_cmd,
-    &help_cmd,
     &adc_cmd,
-    &vref_cmd,
-    &temp_cmd,
+    &baud_cmd,
+    &binary_cmd,
     &button_cmd,
+    &channel_cmd,
+    &clock_cmd,
+    &format_cmd,
+    &gpio_cmd,
+    &help_cmd,
     &led_cmd,
+    &pwm_cmd,
+    &reset_cmd,
+    &serial_cmd,
+    &temp_cmd,
+    &vref_cmd,
     NULL,
 };
 
-bool command_match_name(const command *cmd, const char *name)
+static const char *command_name_at(const void *table, size_t i)
+{
+    return ((const command *const *) table)[i]->name;
+}
+
+const command *command_find(const char *name)
+{
+    int16_t i = lookup_sorted(commands, ARRAY_LEN(commands) - 1,
+            &command_name_at, name);
+    return (i < 0) ? NULL : commands[i];
+}
+
+static bool keywords_sorted(const keyword *table, size_t count)
+{
+    for (size_t i = 1; i < count; ++i)
+    {
+        if (strcasecmp(table[i - 1].name, table[i].name) >= 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool forms_sorted(const command *cmd)
+{
+    const char *previous = NULL;
+    for (uint8_t i = 0; i < cmd->form_count; ++i)
+    {
+        const command_form *form = &cmd->forms[i];
+        // Only the first form can go without a keyword.
+        if (form->keyword == NULL)
+        {
+            if (i > 0)
+            {
+                return false;
+            }
+        }
+        else if ((previous != NULL)
+                && (strcasecmp(previous, form->keyword) >= 0))
+        {
+            return false;
+        }
+        previous = form->keyword;
+
+        for (uint8_t k = 0; k < form->count; ++k)
+        {
+            const arg_spec *spec = &form->args[k];
+            if ((spec->type == ARG_ENUM)
+                    && !keywords_sorted(spec->keywords, spec->keyword_count))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const command *command_check_sorted(void)
+{
+    for (size_t i = 0; commands[i] != NULL; ++i)
+    {
+        if (((i > 0) && (strcasecmp(commands[i - 1]->name,
+                commands[i]->name) >= 0)) || !forms_sorted(commands[i]))
+        {
+            return commands[i];
+        }
+    }
+    return NULL;
+}
+
+static const keyword on_off_keywords[] = {
+    { .name = "OFF", .value = false, },
+    { .name = "ON", .value = true, },
+};
+
+const arg_spec arg_on_off = ARG_SPEC_ENUM(on_off_keywords);
+
+static bool parse_int(const arg_spec *spec, const char *arg, int32_t *value)
+{
+    // We have to clear out `errno` so we can tell whether the conversion is
+    // valid.
+    errno = 0;
+    char *end_ptr = NULL;
+    int32_t converted = strtol(arg, &end_ptr, 10);
+    if ((errno != 0) || (end_ptr == arg) || (*end_ptr != '\0'))
+    {
+        return false;
+    }
+    if ((converted < spec->min) || (converted > spec->max))
+    {
+        return false;
+    }
+
+    *value = converted;
+    return true;
+}
+
+static bool parse_value(const arg_spec *spec, const char *arg,
+        arg_value *value)
+{
+    switch (spec->type)
+    {
+    case ARG_ENUM:
+    {
+        const keyword *found = keyword_lookup(spec->keywords,
+                spec->keyword_count, arg);
+        if (found == NULL)
+        {
+            return false;
+        }
+        value->number = found->value;
+        return true;
+    }
+    case ARG_CHANNEL:
+        if (toupper(arg[0]) != 'A')
+        {
+            return false;
+        }
+        return parse_int(spec, &arg[1], &value->number);
+    case ARG_PIN:
+    {
+        uint8_t pin;
+        if (!pin_parse(arg, &pin))
+        {
+            return false;
+        }
+        value->number = pin;
+        return true;
+    }
+    case ARG_INT:
+        return parse_int(spec, arg, &value->number);
+    case ARG_WORD:
+        value->text = arg;
+        return true;
+    }
+    return false;
+}
+
+static bool parse_form(const command_form *form, uint8_t argc,
+        const char *const *argv, command_args *parsed)
+{
+    if (((argc < form->required) && !(form->or_none && (argc == 0)))
+            || (argc > form->count))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < argc; ++i)
+    {
+        if (!parse_value(&form->args[i], argv[i], &parsed->values[i]))
+        {
+            return false;
+        }
+    }
+    parsed->count = argc;
+    return true;
+}
+
+static void print_synopsis(FILE *out, const command *cmd,
+        const command_form *form)
+{
+    fprintf(out, "%s", cmd->name);
+    if (form->keyword != NULL)
+    {
+        fprintf(out, " %s", form->keyword);
+    }
+    if (form->or_none)
+    {
+        fprintf(out, " [");
+    }
+
+    for (uint8_t i = 0; i < form->count; ++i)
+    {
+        const arg_spec *spec = &form->args[i];
+        // Enums are already in brackets either way.
+        bool bracket = (i >= form->required) && (spec->type != ARG_ENUM);
+        // The bracket around them all already leaves the first one spaced.
+        if (!form->or_none || (i > 0))
+        {
+            putc(' ', out);
+        }
+        if (bracket)
+        {
+            putc('[', out);
+        }
+
+        switch (spec->type)
+        {
+        case ARG_ENUM:
+            putc('[', out);
+            for (uint8_t k = 0; k < spec->keyword_count; ++k)
+            {
+                fprintf(out, k == 0 ? "%s" : "|%s",
+                        spec->keywords[k].name);
+            }
+            putc(']', out);
+            break;
+        case ARG_CHANNEL:
+            fprintf(out, "A<%s>", spec->name);
+            break;
+        case ARG_INT:
+        case ARG_PIN:
+        case ARG_WORD:
+            fprintf(out, "<%s>", spec->name);
+            break;
+        }
+
+        if (bracket)
+        {
+            putc(']', out);
+        }
+    }
+    if (form->or_none)
+    {
+        putc(']', out);
+    }
+}
+
+static void print_ranges(FILE *out, const command_form *form)
 {
-    return strcasecmp(cmd->name, name) == 0;
-}
\ No newline at end of file
+    for (uint8_t i = 0; i < form->count; ++i)
+    {
+        const arg_spec *spec = &form->args[i];
+        if ((spec->type == ARG_INT) || (spec->type == ARG_CHANNEL))
+        {
+            fprintf(out, " (%"PRId32" <= %s <= %"PRId32")",
+                    spec->min, spec->name, spec->max);
+        }
+    }
+}
+
+static void print_usage(const command *cmd, const command_form *form)
+{
+    FILE *out = reply_begin_error();
+    fprintf(out, "Usage: ");
+    print_synopsis(out, cmd, form);
+    print_ranges(out, form);
+    reply_end_error();
+}
+
+void command_print_help(const command *cmd)
+{
+    for (uint8_t i = 0; i < cmd->form_count; ++i)
+    {
+        const command_form *form = &cmd->forms[i];
+        putchar('\t');
+        print_synopsis(stdout, cmd, form);
+        printf("\t%s", form->help);
+        print_ranges(stdout, form);
+        printf("\r\n");
+    }
+}
+
+static const char *form_keyword_at(const void *table, size_t i)
+{
+    return ((const command_form *) table)[i].keyword;
+}
+
+bool command_parse(const command *cmd, uint8_t argc, const char *const *argv,
+        command_args *parsed)
+{
+    const command_form *forms = cmd->forms;
+    uint8_t first_keyword = 0;
+    if ((cmd->form_count > 0) && (forms[0].keyword == NULL))
+    {
+        first_keyword = 1;
+    }
+
+    // A subcommand decides the form by itself.
+    if (argc > 0)
+    {
+        int16_t i = lookup_sorted(&forms[first_keyword],
+                cmd->form_count - first_keyword, &form_keyword_at, argv[0]);
+        if (i >= 0)
+        {
+            parsed->form = first_keyword + i;
+            const command_form *form = &forms[parsed->form];
+            if (parse_form(form, argc - 1, &argv[1], parsed))
+            {
+                return true;
+            }
+            print_usage(cmd, form);
+            return false;
+        }
+    }
+
+    // Otherwise the arguments have to fit the form without a keyword.
+    if (first_keyword)
+    {
+        parsed->form = 0;
+        if (parse_form(&forms[0], argc, argv, parsed))
+        {
+            return true;
+        }
+        if ((forms[0].count > 0) && (argc <= forms[0].count))
+        {
+            print_usage(cmd, &forms[0]);
+            return false;
+        }
+    }
+
+    if (argc > 0)
+    {
+        reply_error("Unknown argument: %s", argv[0]);
+    }
+    else
+    {
+        for (uint8_t i = 0; i < cmd->form_count; ++i)
+        {
+            print_usage(cmd, &forms[i]);
+        }
+    }
+    return false;
+}
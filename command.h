@@ -1,4 +1,4 @@
-/* 
+/*
  * File:   command.h
  * Author: Jani Juhani Sinervo
  *
@@ -14,21 +14,122 @@ extern "C" {
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
-    
+
+#include "util.h"
+#include "keyword.h"
+
+typedef enum ARG_TYPE {
+    // One of the names in a keyword table, parsed into the keyword's value.
+    ARG_ENUM,
+    // A decimal integer between `min` and `max`.
+    ARG_INT,
+    // An analog input `A<n>`, with n between `min` and `max`. Parsed into n.
+    ARG_CHANNEL,
+    // A pin like PF5, parsed into its number. See pin.h.
+    ARG_PIN,
+    // Any text at all.
+    ARG_WORD,
+} arg_type;
+
+// Describes a single argument, so that it can be validated, and the usage
+// and help texts written, without each command doing it by hand.
+typedef struct ARG_SPEC {
+    arg_type type;
+    // Used as the placeholder in usage texts, as in `<n>`.
+    const char *name;
+    const keyword *keywords;
+    uint8_t keyword_count;
+    int32_t min;
+    int32_t max;
+} arg_spec;
+
+#define ARG_SPEC_ENUM(table) { .type = ARG_ENUM, .keywords = (table), \
+    .keyword_count = ARRAY_LEN(table), }
+#define ARG_SPEC_INT(n, lo, hi) { .type = ARG_INT, .name = (n), \
+    .min = (lo), .max = (hi), }
+#define ARG_SPEC_CHANNEL(lo, hi) { .type = ARG_CHANNEL, .name = "n", \
+    .min = (lo), .max = (hi), }
+#define ARG_SPEC_PIN(n) { .type = ARG_PIN, .name = (n), }
+#define ARG_SPEC_WORD(n) { .type = ARG_WORD, .name = (n), }
+
+// One way of invoking a command, like `LED SET <n>`.
+typedef struct COMMAND_FORM {
+    // The subcommand this form starts with, or NULL if the arguments follow
+    // the command name directly.
+    const char *keyword;
+    const arg_spec *args;
+    // The first `required` of the `count` arguments have to be given.
+    uint8_t required;
+    uint8_t count;
+    // Whether the form can also be given without any arguments, even though
+    // some are required otherwise, like a query next to a setting.
+    bool or_none;
+    // Describes the form within HELP <command>.
+    const char *help;
+} command_form;
+
+typedef union ARG_VALUE {
+    int32_t number;
+    const char *text;
+} arg_value;
+
+// The arguments of a command, already checked against one of its forms.
+typedef struct COMMAND_ARGS {
+    // Index of the form that matched.
+    uint8_t form;
+    // How many arguments were given after the keyword.
+    uint8_t count;
+    arg_value values[ARGS_MAX];
+} command_args;
+
+// How running a command went.
+typedef enum COMMAND_STATUS {
+    COMMAND_OK,
+    // The arguments didn't fit any of the command's forms.
+    COMMAND_BAD_ARGUMENTS,
+    // The command couldn't do what it was asked to.
+    COMMAND_FAILED,
+    COMMAND_NO_SUCH_COMMAND,
+} command_status;
+
 typedef struct COMMAND {
     const char *name;
     // Describes the command shortly, within the simple invocation of HELP.
     const char *short_help_blurb;
-    
+
+    // The forms with a keyword are sorted by it, so they can be looked up
+    // like commands themselves. A form without a keyword comes first.
+    const command_form *forms;
+    uint8_t form_count;
+
     void (*init)(void);
-    bool (*execute)(char *arglist, const char *arglist_end);
-    void (*print_help_text)(void);
+    command_status (*execute)(const command_args *args);
 } command;
 
-bool command_match_name(const command *cmd, const char *name);
+// Finds a command by its name, or any unique prefix of it. Returns NULL if
+// there's no such command.
+const command *command_find(const char *name);
+
+// Checks that the commands, the keyword forms of each and the keywords of
+// each argument are sorted the way `lookup_sorted` needs them. Returns the
+// first command that's out of place or has a table out of order, or NULL
+// if they're all fine.
+const command *command_check_sorted(void);
 
-// A NULL-pointer terminated list of commands.
+// Matches the arguments after the command name against the command's forms
+// and parses them. Prints what's wrong and returns false if none fits.
+bool command_parse(const command *cmd, uint8_t argc, const char *const *argv,
+        command_args *parsed);
+
+// Prints a line for each form of the command, for HELP.
+void command_print_help(const command *cmd);
+
+// The usual argument for turning something on or off.
+extern const arg_spec arg_on_off;
+
+// A NULL-pointer terminated list of commands, sorted by name.
 extern const command *commands[];
 
 #ifdef	__cplusplus
@@ -36,4 +137,3 @@ extern const command *commands[];
 #endif
 
 #endif	/* COMMAND_H */
-
@@ -0,0 +1,190 @@
+/*
+ * File:   filter.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:15
+ */
+
+#include "filter.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The products are shifted down this much before they're added up, which
+// keeps the sum of FILTER_FIR_TAPS of them within 32 bits. What gets lost
+// is far below the final rounding.
+#define FIR_PRESHIFT 3
+
+static filter_kind kind = FILTER_NONE;
+static uint8_t size = 0;
+static int16_t coefficients[FILTER_FIR_TAPS];
+static uint8_t decimation = 1;
+
+// The previous samples of the average and the FIR, newest at `newest`.
+static uint16_t history[FILTER_FIR_TAPS > (1 << FILTER_AVERAGE_MAX_SHIFT)
+        ? FILTER_FIR_TAPS : (1 << FILTER_AVERAGE_MAX_SHIFT)];
+static uint8_t newest;
+// The IIR's output with `size` fraction bits, or the sum of the average.
+static uint32_t accumulator;
+static bool primed;
+static uint8_t skipped;
+
+void filter_set_none(void)
+{
+    kind = FILTER_NONE;
+    size = 0;
+}
+
+void filter_set_iir(uint8_t shift)
+{
+    kind = FILTER_IIR;
+    size = shift;
+}
+
+void filter_set_average(uint8_t shift)
+{
+    kind = FILTER_AVERAGE;
+    size = shift;
+}
+
+bool filter_set_fir(const int16_t *taps, uint8_t count)
+{
+    uint32_t gain = 0;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        gain += abs(taps[i]);
+    }
+    if ((count == 0) || (count > FILTER_FIR_TAPS) || (gain > 0x10000UL))
+    {
+        return false;
+    }
+
+    kind = FILTER_FIR;
+    size = count;
+    memcpy(coefficients, taps, count * sizeof(*taps));
+    return true;
+}
+
+filter_kind filter_get_kind(void)
+{
+    return kind;
+}
+
+uint8_t filter_get_size(void)
+{
+    return size;
+}
+
+void filter_set_decimation(uint8_t n)
+{
+    decimation = n;
+}
+
+uint8_t filter_get_decimation(void)
+{
+    return decimation;
+}
+
+uint16_t filter_settle_samples(void)
+{
+    switch (kind)
+    {
+    case FILTER_IIR:
+        // Within 2 % of a step after four time constants.
+        return 4U << size;
+    case FILTER_AVERAGE:
+        return 1U << size;
+    case FILTER_FIR:
+        return size;
+    case FILTER_NONE:
+        break;
+    }
+    return 1;
+}
+
+void filter_reset(void)
+{
+    primed = false;
+    skipped = 0;
+}
+
+// Fills the memory with the first sample.
+static void prime(uint16_t in)
+{
+    for (uint8_t i = 0; i < sizeof(history) / sizeof(*history); ++i)
+    {
+        history[i] = in;
+    }
+    newest = 0;
+    // Both the IIR's output and the sum of the average are the sample
+    // times 2^size.
+    accumulator = (uint32_t) in << size;
+    primed = true;
+}
+
+static uint16_t round_shift(uint32_t value, uint8_t shift)
+{
+    return (shift == 0) ? value
+            : (uint16_t) ((value + (1UL << (shift - 1))) >> shift);
+}
+
+static uint16_t fir(uint16_t in)
+{
+    newest = (newest + 1) % FILTER_FIR_TAPS;
+    history[newest] = in;
+
+    int32_t sum = 0;
+    uint8_t k = newest;
+    for (uint8_t i = 0; i < size; ++i)
+    {
+        sum += ((int32_t) coefficients[i] * history[k]) >> FIR_PRESHIFT;
+        k = (k == 0) ? FILTER_FIR_TAPS - 1 : k - 1;
+    }
+    sum = (sum + (1L << (14 - FIR_PRESHIFT))) >> (15 - FIR_PRESHIFT);
+    if (sum < 0)
+    {
+        return 0;
+    }
+    return (sum > UINT16_MAX) ? UINT16_MAX : (uint16_t) sum;
+}
+
+bool filter_apply(uint16_t in, uint16_t *out)
+{
+    if (!primed)
+    {
+        prime(in);
+    }
+
+    switch (kind)
+    {
+    case FILTER_NONE:
+        *out = in;
+        break;
+    case FILTER_IIR:
+        // Keeping the output with fraction bits keeps small steps from
+        // getting lost.
+        accumulator -= round_shift(accumulator, size);
+        accumulator += in;
+        *out = round_shift(accumulator, size);
+        break;
+    case FILTER_AVERAGE:
+    {
+        uint8_t mask = (1 << size) - 1;
+        newest = (newest + 1) & mask;
+        accumulator += in;
+        accumulator -= history[newest];
+        history[newest] = in;
+        *out = round_shift(accumulator, size);
+        break;
+    }
+    case FILTER_FIR:
+        *out = fir(in);
+        break;
+    }
+
+    if (++skipped < decimation)
+    {
+        return false;
+    }
+    skipped = 0;
+    return true;
+}
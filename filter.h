@@ -0,0 +1,73 @@
+/*
+ * File:   filter.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:15
+ */
+
+#ifndef FILTER_H
+#define	FILTER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A filter stage for the ADC's samples, cheap enough to run in the
+// conversion-complete interrupt. Everything is integer math; the FIR's
+// coefficients are Q15, and each tap is a 16 by 16-bit multiply, which the
+// AVR does with four of its 8 by 8-bit ones.
+//
+// There's a single stage, set up by ADC FILTER, which whoever is sampling
+// resets and feeds one sample at a time.
+
+typedef enum FILTER_KIND {
+    FILTER_NONE,
+    // Single-pole, y += (x - y) / 2^shift.
+    FILTER_IIR,
+    // The mean of the last 2^shift samples.
+    FILTER_AVERAGE,
+    // Up to FILTER_FIR_TAPS Q15 coefficients, the first one for the newest
+    // sample.
+    FILTER_FIR,
+} filter_kind;
+
+#define FILTER_IIR_MAX_SHIFT 8
+#define FILTER_AVERAGE_MAX_SHIFT 4
+#ifndef FILTER_FIR_TAPS
+#define FILTER_FIR_TAPS 8
+#endif
+
+void filter_set_none(void);
+void filter_set_iir(uint8_t shift);
+void filter_set_average(uint8_t shift);
+// Returns false unless the absolute values of the coefficients add up to
+// at most 2.0, which keeps the sums from overflowing.
+bool filter_set_fir(const int16_t *coefficients, uint8_t count);
+
+filter_kind filter_get_kind(void);
+// The shift of the IIR or the average, or the number of the FIR's taps.
+uint8_t filter_get_size(void);
+
+// Only lets every `n`th filtered sample through, to cut the rate down.
+void filter_set_decimation(uint8_t n);
+uint8_t filter_get_decimation(void);
+
+// How many samples it takes the filter to settle, for single readings.
+uint16_t filter_settle_samples(void);
+
+// Forgets the previous samples. The next one fills the filter's memory, so
+// it starts out settled on it.
+void filter_reset(void);
+
+// Filters a sample into `*out`. Returns true if that's to be let through
+// after the decimation.
+bool filter_apply(uint16_t in, uint16_t *out);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FILTER_H */
@@ -0,0 +1,65 @@
+/*
+ * File:   format-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 02:30
+ */
+
+#include "format-command.h"
+#include "line-editor.h"
+#include "reply.h"
+#include "util.h"
+
+static void format_command_init(void);
+static command_status format_command_execute(const command_args *args);
+
+// Sorted by name, see `keyword_lookup`.
+static const keyword format_args[] = {
+    { .name = "CSV", .value = REPLY_CSV, },
+    { .name = "HUMAN", .value = REPLY_HUMAN, },
+    { .name = "JSON", .value = REPLY_JSON, },
+    { .name = "TERSE", .value = REPLY_TERSE, },
+};
+
+static const arg_spec format_set_args[] = {
+    ARG_SPEC_ENUM(format_args),
+};
+
+static const command_form format_forms[] = {
+    {
+        .args = format_set_args, .count = 1,
+        .help = "Prints or sets the output format",
+    },
+};
+
+const command format_cmd = {
+    .name = "FORMAT",
+    .short_help_blurb = "Switches between human and machine-readable output",
+
+    .forms = format_forms,
+    .form_count = ARRAY_LEN(format_forms),
+
+    .init = &format_command_init,
+    .execute = &format_command_execute,
+};
+
+static void format_command_init(void)
+{
+}
+
+static command_status format_command_execute(const command_args *args)
+{
+    if (args->count > 0)
+    {
+        reply_format format = (reply_format) args->values[0].number;
+        reply_set_format(format);
+        // Programs don't want their commands echoed back, or prompts.
+        line_editor_set_echo(format == REPLY_HUMAN);
+    }
+    else
+    {
+        reply_keyword("format", "Output format", format_args,
+                ARRAY_LEN(format_args), reply_get_format());
+    }
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   format-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 02:30
+ */
+
+#ifndef FORMAT_COMMAND_H
+#define	FORMAT_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command format_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FORMAT_COMMAND_H */
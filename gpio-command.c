@@ -0,0 +1,328 @@
+/*
+ * File:   gpio-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:50
+ */
+
+#include "gpio-command.h"
+#include "pin.h"
+#include "pwm.h"
+#include "util.h"
+#include "reply.h"
+#include <avr/io.h>
+#include <util/atomic.h>
+
+static void gpio_command_init(void);
+static command_status gpio_command_execute(const command_args *args);
+
+static const keyword port_args[] = {
+    { .name = "A", .value = 0, },
+    { .name = "B", .value = 1, },
+    { .name = "C", .value = 2, },
+    { .name = "D", .value = 3, },
+    { .name = "E", .value = 4, },
+    { .name = "F", .value = 5, },
+};
+
+static const keyword dir_args[] = {
+    { .name = "IN", .value = false, },
+    { .name = "OUT", .value = true, },
+};
+
+static const keyword level_args[] = {
+    { .name = "HIGH", .value = true, },
+    { .name = "LOW", .value = false, },
+};
+
+static const keyword switch_args[] = {
+    { .name = "OFF", .value = false, },
+    { .name = "ON", .value = true, },
+};
+
+enum
+{
+    GPIO_FORM_SHOW,
+    GPIO_FORM_DIR,
+    GPIO_FORM_INV,
+    GPIO_FORM_PORT,
+    GPIO_FORM_PUP,
+    GPIO_FORM_READ,
+    GPIO_FORM_SET,
+};
+
+static const arg_spec show_args[] = {
+    ARG_SPEC_PIN("pin"),
+};
+
+static const arg_spec dir_pin_args[] = {
+    ARG_SPEC_PIN("pin"),
+    ARG_SPEC_ENUM(dir_args),
+};
+
+static const arg_spec level_pin_args[] = {
+    ARG_SPEC_PIN("pin"),
+    ARG_SPEC_ENUM(level_args),
+};
+
+static const arg_spec switch_pin_args[] = {
+    ARG_SPEC_PIN("pin"),
+    ARG_SPEC_ENUM(switch_args),
+};
+
+static const arg_spec port_write_args[] = {
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_INT("value", 0, 255),
+    ARG_SPEC_INT("mask", 0, 255),
+};
+
+static const arg_spec read_args[] = {
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_ENUM(port_args),
+    ARG_SPEC_ENUM(port_args),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form gpio_forms[] = {
+    [GPIO_FORM_SHOW] = {
+        .args = show_args, .count = 1,
+        .help = "Reads all the ports, or shows how a pin is set up",
+    },
+    [GPIO_FORM_DIR] = {
+        .keyword = "DIR", .args = dir_pin_args, .required = 2, .count = 2,
+        .help = "Makes a pin an input or an output",
+    },
+    [GPIO_FORM_INV] = {
+        .keyword = "INV", .args = switch_pin_args, .required = 2,
+        .count = 2,
+        .help = "Inverts a pin",
+    },
+    [GPIO_FORM_PORT] = {
+        .keyword = "PORT", .args = port_write_args, .required = 1,
+        .count = 3,
+        .help = "Shows a port, or writes the output pins in the mask",
+    },
+    [GPIO_FORM_PUP] = {
+        .keyword = "PUP", .args = switch_pin_args, .required = 2,
+        .count = 2,
+        .help = "Configures the pull-up resistor of a pin",
+    },
+    [GPIO_FORM_READ] = {
+        .keyword = "READ", .args = read_args, .count = ARRAY_LEN(read_args),
+        .help = "Samples the inputs of the ports all at once",
+    },
+    [GPIO_FORM_SET] = {
+        .keyword = "SET", .args = level_pin_args, .required = 2,
+        .count = 2,
+        .help = "Drives an output pin high or low",
+    },
+};
+
+const command gpio_cmd = {
+    .name = "GPIO",
+    .short_help_blurb = "Reads and writes the pins and ports",
+
+    .forms = gpio_forms,
+    .form_count = ARRAY_LEN(gpio_forms),
+
+    .init = &gpio_command_init,
+    .execute = &gpio_command_execute,
+};
+
+static void gpio_command_init(void)
+{
+}
+
+// What the pin is already used for, or NULL if it's free to be changed.
+static const char *taken_by(uint8_t pin)
+{
+    const char *owner = pin_owner(pin);
+    if (owner != NULL)
+    {
+        return owner;
+    }
+
+    for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+    {
+        uint8_t channel_pin;
+        uint8_t duty;
+        if (pwm_get(i, &channel_pin, &duty) && (channel_pin == pin))
+        {
+            return "PWM";
+        }
+    }
+    return NULL;
+}
+
+// Checks that none of the pins in `mask` of the port are used for anything
+// else, and says which one is if there is.
+static bool pins_free(uint8_t port, uint8_t mask)
+{
+    for (uint8_t bit = 0; bit < 8; ++bit)
+    {
+        if (!(mask & (1 << bit)))
+        {
+            continue;
+        }
+
+        uint8_t pin = port * 8 + bit;
+        const char *owner = taken_by(pin);
+        if (owner != NULL)
+        {
+            char name[4];
+            pin_name(pin, name);
+            reply_error("%s is taken by the %s", name, owner);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void set_bit(volatile uint8_t *reg, uint8_t mask, bool on)
+{
+    // Interrupts may be writing to the same register, like the PWM does.
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (on)
+        {
+            *reg |= mask;
+        }
+        else
+        {
+            *reg &= ~mask;
+        }
+    }
+}
+
+static void show_pin(uint8_t pin)
+{
+    VPORT_t *vport = &PIN_VPORT(pin);
+    uint8_t mask = PIN_MASK(pin);
+    uint8_t ctrl = PIN_CTRL(pin);
+
+    reply_bool("in", "Input", vport->IN & mask);
+    reply_keyword("dir", "Direction", dir_args, ARRAY_LEN(dir_args),
+            (vport->DIR & mask) != 0);
+    reply_keyword("out", "Output", level_args, ARRAY_LEN(level_args),
+            (vport->OUT & mask) != 0);
+    reply_bool("pullup", "Pull-up resistor", ctrl & PORT_PULLUPEN_bm);
+    reply_bool("invert", "Inverted", ctrl & PORT_INVEN_bm);
+}
+
+static const char *const port_keys[PIN_PORT_COUNT] = {
+    "a", "b", "c", "d", "e", "f",
+};
+
+static const char *const port_labels[PIN_PORT_COUNT] = {
+    "PORTA", "PORTB", "PORTC", "PORTD", "PORTE", "PORTF",
+};
+
+// Samples the inputs of the ports given as arguments, or of all of them if
+// there are none, within a few cycles of each other.
+static void read_ports(const command_args *args)
+{
+    uint8_t in[PIN_PORT_COUNT];
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        in[0] = VPORTA.IN;
+        in[1] = VPORTB.IN;
+        in[2] = VPORTC.IN;
+        in[3] = VPORTD.IN;
+        in[4] = VPORTE.IN;
+        in[5] = VPORTF.IN;
+    }
+
+    if (args->count == 0)
+    {
+        for (uint8_t port = 0; port < PIN_PORT_COUNT; ++port)
+        {
+            reply_u8(port_keys[port], port_labels[port], in[port]);
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < args->count; ++i)
+    {
+        uint8_t port = args->values[i].number;
+        reply_u8(port_keys[port], port_labels[port], in[port]);
+    }
+}
+
+static command_status port_command(const command_args *args)
+{
+    uint8_t port = args->values[0].number;
+    VPORT_t *vport = &PIN_PORT_VPORT(port);
+
+    if (args->count == 1)
+    {
+        reply_u8("in", "Input", vport->IN);
+        reply_u8("dir", "Direction", vport->DIR);
+        reply_u8("out", "Output", vport->OUT);
+        return COMMAND_OK;
+    }
+
+    uint8_t value = args->values[1].number;
+    uint8_t mask = (args->count > 2) ? args->values[2].number : 0xFF;
+    if (!pins_free(port, mask))
+    {
+        return COMMAND_FAILED;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        vport->OUT = (vport->OUT & ~mask) | (value & mask);
+    }
+    return COMMAND_OK;
+}
+
+static command_status gpio_command_execute(const command_args *args)
+{
+    uint8_t pin = (args->count > 0) ? args->values[0].number : 0;
+    bool on = (args->count > 1) && args->values[1].number;
+
+    switch (args->form)
+    {
+    case GPIO_FORM_PORT:
+        return port_command(args);
+    case GPIO_FORM_READ:
+        read_ports(args);
+        return COMMAND_OK;
+    case GPIO_FORM_SHOW:
+        if (args->count == 0)
+        {
+            read_ports(args);
+        }
+        else
+        {
+            show_pin(pin);
+        }
+        return COMMAND_OK;
+    default:
+        break;
+    }
+
+    // The rest change the pin.
+    if (!pins_free(PIN_PORT(pin), PIN_MASK(pin)))
+    {
+        return COMMAND_FAILED;
+    }
+
+    switch (args->form)
+    {
+    case GPIO_FORM_DIR:
+        set_bit(&PIN_VPORT(pin).DIR, PIN_MASK(pin), on);
+        break;
+    case GPIO_FORM_INV:
+        set_bit(&PIN_CTRL(pin), PORT_INVEN_bm, on);
+        break;
+    case GPIO_FORM_PUP:
+        set_bit(&PIN_CTRL(pin), PORT_PULLUPEN_bm, on);
+        break;
+    case GPIO_FORM_SET:
+        set_bit(&PIN_VPORT(pin).OUT, PIN_MASK(pin), on);
+        break;
+    }
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   gpio-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:50
+ */
+
+#ifndef GPIO_COMMAND_H
+#define	GPIO_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command gpio_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* GPIO_COMMAND_H */
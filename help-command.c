@@ -6,48 +6,53 @@
  */
 
 #include "help-command.h"
+#include "reply.h"
 #include "util.h"
 
 static void help_command_init(void);
-static bool help_command_execute(char *arglist, const char *arglist_end);
-static void help_command_print_help_text(void);
+static command_status help_command_execute(const command_args *args);
+
+static const arg_spec help_args[] = {
+    ARG_SPEC_WORD("command"),
+};
+
+static const command_form help_forms[] = {
+    {
+        .args = help_args, .count = 1,
+        .help = "Print a summary of available commands, or help for one",
+    },
+};
 
 const command help_cmd = {
     .name = "HELP",
     .short_help_blurb = "Displays help for commands",
 
+    .forms = help_forms,
+    .form_count = ARRAY_LEN(help_forms),
+
     .init = &help_command_init,
     .execute = &help_command_execute,
-    .print_help_text = &help_command_print_help_text,
 };
 
 static void help_command_init(void)
 {
 }
 
-static bool help_command_execute(char *arglist, const char *arglist_end)
+static command_status help_command_execute(const command_args *args)
 {
-    char *arg = arglist;
     // If we got arguments, let's check if they match a command
-    if (iterate_args(&arg, &arglist, arglist_end)) {
-        bool found_command = false;
-        for (const command **cmd = commands; *cmd != NULL; ++cmd) {
-            if (command_match_name(*cmd, arg)) {
-                const command *c = *cmd;
-                printf("Available %s commands:\r\n", c->name);
+    if (args->count > 0) {
+        const char *arg = args->values[0].text;
+        const command *c = command_find(arg);
+        if (c != NULL) {
+            printf("Available %s commands:\r\n", c->name);
 
-                c->print_help_text();
-
-                found_command = true;
-                break;
-            }
-        }
-
-        if (!found_command) {
-            printf("HELP: No such command: %s\r\n", arg);
+            command_print_help(c);
+        } else {
+            reply_error("No such command: %s", arg);
         }
 
-        return found_command;
+        return (c != NULL) ? COMMAND_OK : COMMAND_BAD_ARGUMENTS;
     } else {
         printf("Available commands:\r\n");
         for (const command **cmd = commands; *cmd != NULL; ++cmd) {
@@ -55,11 +60,5 @@ static bool help_command_execute(char *arglist, const char *arglist_end)
             printf("\t%s\t%s\r\n", c->name, c->short_help_blurb);
         }
     }
-    return true;
-}
-
-static void help_command_print_help_text(void)
-{
-    printf("\tHELP\tPrint a summary of available commands\r\n");
-    printf("\tHELP <command>\tShow help for given command\r\n");
+    return COMMAND_OK;
 }
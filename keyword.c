@@ -0,0 +1,81 @@
+/*
+ * File:   keyword.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:05
+ */
+
+#include "keyword.h"
+#include <string.h>
+#include <stdbool.h>
+
+int16_t lookup_sorted(const void *table, size_t count,
+        const char *(*name_at)(const void *table, size_t i),
+        const char *name)
+{
+    // Find the first entry which isn't less than `name`. Since the table is
+    // sorted, that's either the exact match or the first of the entries
+    // that `name` is a prefix of.
+    size_t low = 0;
+    size_t high = count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (strcasecmp(name_at(table, middle), name) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low == count)
+    {
+        return -1;
+    }
+
+    const char *found = name_at(table, low);
+    if (strcasecmp(found, name) == 0)
+    {
+        return low;
+    }
+
+    // Not exact, so it has to be a prefix of this entry and this entry only.
+    size_t length = strlen(name);
+    if ((length == 0) || (strncasecmp(found, name, length) != 0))
+    {
+        return -1;
+    }
+    if ((low + 1 < count)
+            && (strncasecmp(name_at(table, low + 1), name, length) == 0))
+    {
+        return -1;
+    }
+    return low;
+}
+
+static const char *keyword_name_at(const void *table, size_t i)
+{
+    return ((const keyword *) table)[i].name;
+}
+
+const keyword *keyword_lookup(const keyword *table, size_t count,
+        const char *name)
+{
+    int16_t i = lookup_sorted(table, count, &keyword_name_at, name);
+    return (i < 0) ? NULL : &table[i];
+}
+
+const char *keyword_name(const keyword *table, size_t count, uint8_t value)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (table[i].value == value)
+        {
+            return table[i].name;
+        }
+    }
+    return NULL;
+}
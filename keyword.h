@@ -0,0 +1,47 @@
+/*
+ * File:   keyword.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:05
+ */
+
+#ifndef KEYWORD_H
+#define	KEYWORD_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maps a name, like a subcommand or an option, to a value.
+typedef struct KEYWORD {
+    const char *name;
+    uint8_t value;
+} keyword;
+
+// Looks up `name` in a table of `count` entries whose names, as given by
+// `name_at`, are sorted in case-insensitive `strcasecmp` order. The search is
+// a binary search, so it stays cheap however long the table gets.
+//
+// Any prefix of a name that's unique within the table matches it, but an
+// exact match always wins. Returns the index of the match, or -1 if there
+// is none or the prefix is ambiguous.
+int16_t lookup_sorted(const void *table, size_t count,
+        const char *(*name_at)(const void *table, size_t i),
+        const char *name);
+
+// Same as `lookup_sorted` for a sorted keyword table. Returns NULL if
+// nothing matched.
+const keyword *keyword_lookup(const keyword *table, size_t count,
+        const char *name);
+
+// Finds the name of a value. Linear, since it's only used for printing.
+const char *keyword_name(const keyword *table, size_t count, uint8_t value);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* KEYWORD_H */
@@ -8,197 +8,514 @@
 #include "led-command.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <string.h>
-#include <stdlib.h>
-#include <errno.h>
-#include "util.h"
-
 #include <inttypes.h>
+#include "util.h"
+#include "reply.h"
+#include "clock.h"
 
 static void led_command_init(void);
-static bool led_command_execute(char *arglist, const char *arglist_end);
-static void led_command_print_help_text(void);
+static command_status led_command_execute(const command_args *args);
+
+enum
+{
+    LED_FORM_SWITCH,
+    LED_FORM_BLINK,
+    LED_FORM_BREATHE,
+    LED_FORM_FADE,
+    LED_FORM_FREQ,
+    LED_FORM_SET,
+};
+
+static const arg_spec blink_args[] = {
+    ARG_SPEC_INT("on_ms", 1, 65535),
+    ARG_SPEC_INT("off_ms", 1, 65535),
+    ARG_SPEC_INT("count", 1, 65535),
+};
+
+static const arg_spec breathe_args[] = {
+    ARG_SPEC_INT("ms", 2, 65535),
+};
+
+static const arg_spec fade_args[] = {
+    ARG_SPEC_INT("from", 0, 255),
+    ARG_SPEC_INT("to", 0, 255),
+    ARG_SPEC_INT("ms", 0, 65535),
+};
+
+static const arg_spec freq_args[] = {
+    ARG_SPEC_INT("hz", 1, 65535),
+};
+
+static const arg_spec set_args[] = {
+    ARG_SPEC_INT("n", 0, 255),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form led_forms[] = {
+    [LED_FORM_SWITCH] = {
+        .args = &arg_on_off, .count = 1,
+        .help = "Query the LED state, or turn the LED on or off",
+    },
+    [LED_FORM_BLINK] = {
+        .keyword = "BLINK", .args = blink_args, .required = 2, .count = 3,
+        .help = "Blink count times, or until told otherwise",
+    },
+    [LED_FORM_BREATHE] = {
+        .keyword = "BREATHE", .args = breathe_args, .required = 1,
+        .count = 1,
+        .help = "Fade up and down again every ms",
+    },
+    [LED_FORM_FADE] = {
+        .keyword = "FADE", .args = fade_args, .required = 3, .count = 3,
+        .help = "Fade from one brightness to another",
+    },
+    [LED_FORM_FREQ] = {
+        .keyword = "FREQ", .args = freq_args, .required = 1, .count = 1,
+        .help = "Set the PWM frequency",
+    },
+    [LED_FORM_SET] = {
+        .keyword = "SET", .args = set_args, .required = 1, .count = 1,
+        .help = "Set LED brightness",
+    },
+};
 
 const command led_cmd = {
     .name = "LED",
     .short_help_blurb = "Displays and configures the LED",
 
+    .forms = led_forms,
+    .form_count = ARRAY_LEN(led_forms),
+
     .init = &led_command_init,
     .execute = &led_command_execute,
-    .print_help_text = &led_command_print_help_text,
 };
 
+// The LED is on PF5, which only TCA0's WO5 reaches, with the timer's output
+// routed to port F. WO5 only exists in split mode, where the timer is two
+// 8-bit counters, so the PWM has at most 256 steps.
+#ifndef LED_PWM_DEFAULT_HZ
+#define LED_PWM_DEFAULT_HZ 1000
+#endif
+// With fewer steps than this the brightness couldn't be set finely enough.
+#define LED_PWM_MIN_STEPS 16
+#define LED_PWM_MAX_STEPS 256
+
+typedef struct PRESCALER {
+    uint16_t division;
+    uint8_t clksel;
+} prescaler;
+
+static const prescaler prescalers[] = {
+    { 1, TCA_SPLIT_CLKSEL_DIV1_gc },
+    { 2, TCA_SPLIT_CLKSEL_DIV2_gc },
+    { 4, TCA_SPLIT_CLKSEL_DIV4_gc },
+    { 8, TCA_SPLIT_CLKSEL_DIV8_gc },
+    { 16, TCA_SPLIT_CLKSEL_DIV16_gc },
+    { 64, TCA_SPLIT_CLKSEL_DIV64_gc },
+    { 256, TCA_SPLIT_CLKSEL_DIV256_gc },
+    { 1024, TCA_SPLIT_CLKSEL_DIV1024_gc },
+};
+
+// Maps brightness, as it's seen, to the duty cycle which gives it, with a
+// gamma of 2.2. Const data stays in flash on this chip, which maps its flash
+// into the data space, so the table costs no RAM.
+static const uint8_t gamma_table[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3,
+    3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6,
+    6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10,
+    11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15,
+    16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 22,
+    22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29,
+    30, 30, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38,
+    39, 39, 40, 41, 42, 43, 43, 44, 45, 46, 47, 48,
+    49, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59,
+    60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71,
+    73, 74, 75, 76, 77, 78, 79, 81, 82, 83, 84, 85,
+    87, 88, 89, 90, 91, 93, 94, 95, 97, 98, 99, 100,
+    102, 103, 105, 106, 107, 109, 110, 111, 113, 114, 116, 117,
+    119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154,
+    156, 158, 159, 161, 163, 165, 166, 168, 170, 172, 173, 175,
+    177, 179, 181, 182, 184, 186, 188, 190, 192, 194, 196, 197,
+    199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246,
+    248, 251, 253, 255,
+};
+
+// A step of a pattern: ramp the brightness to `level` over `ticks`, or jump
+// there right away if `ticks` is zero.
+typedef struct LED_KEYFRAME {
+    uint8_t level;
+    uint16_t ticks;
+} led_keyframe;
+
+#define LED_PATTERN_KEYFRAMES 4
+// The rate the patterns advance at, from the RTC's periodic interrupt.
+// 32768 Hz divided by 128.
+#define LED_PATTERN_TICK_HZ 256
+// Run the keyframes over and over.
+#define LED_PATTERN_FOREVER 0
+
 static void init_timer(void);
+static void init_pattern_timer(void);
 
 static bool is_on = false;
-static volatile bool is_blinking = false;
+static bool is_pwm = false;
 static volatile uint8_t duty_on = 0;
 
+static led_keyframe keyframes[LED_PATTERN_KEYFRAMES];
+static uint8_t keyframe_count = 0;
+static volatile bool pattern_running = false;
+
+// The state of the running pattern, which only the interrupt touches while
+// it runs.
+static uint8_t frame;
+// How many more times to run through the keyframes, counting this one.
+static uint16_t runs_left;
+// The brightness, which steps towards the keyframe's level by `direction`
+// `distance` times over `frame_ticks` ticks, like a line is drawn.
+static uint8_t level;
+static int8_t direction;
+static uint8_t distance;
+static uint16_t frame_ticks;
+static uint16_t ticks_left;
+static uint16_t step_error;
+
+static uint16_t pwm_hz = LED_PWM_DEFAULT_HZ;
+// What the timer has been set up with for `pwm_hz`.
+static const prescaler *pwm_prescaler = &prescalers[0];
+static uint16_t pwm_steps = LED_PWM_MAX_STEPS;
+
 static void led_command_init(void)
 {
-    // Initialise the timer for the PWM action.
+    // The LED lights when PF5 is low. Inverting the pin lets the PWM's duty
+    // cycle be the LED's, and the port's output be whether it's on.
+    PORTF.PIN5CTRL |= PORT_INVEN_bm;
+    // Set the LED as an output, and turn it off by default.
+    VPORTF.OUT &= ~PIN5_bm;
+    VPORTF.DIR |= PIN5_bm;
+
     init_timer();
-    // Set the LED as an output.
-    PORTF.DIRSET = PIN5_bm;
-    // and turn it off by default.
-    PORTF.OUTSET = PIN5_bm;
+    init_pattern_timer();
 }
 
 static void set_led(bool on);
+static void set_duty(uint8_t duty);
+static void stop_pattern(void);
+static void blink(uint16_t on_ms, uint16_t off_ms, uint16_t count);
+static void breathe(uint16_t ms);
+static void fade(uint8_t from, uint8_t to, uint16_t ms);
+static bool set_frequency(uint16_t hz);
+static uint32_t actual_frequency(void);
 
-static bool led_command_execute(char *arglist, const char *arglist_end)
+static command_status led_command_execute(const command_args *args)
 {
-    char *arg = arglist;
-    // If we got arguments, check if it's ON, OFF, or SET
-    if (iterate_args(&arg, &arglist, arglist_end))
+    switch (args->form)
     {
-        if ((strcasecmp(arg, "ON") == 0) || (strcasecmp(arg, "OFF") == 0))
+    case LED_FORM_SWITCH:
+        if (args->count > 0)
         {
-            set_led(strcasecmp(arg, "ON") == 0);
-            return true;
+            set_led(args->values[0].number);
         }
-        else if (strcasecmp(arg, "SET") == 0)
+        else
         {
-            arg = arglist;
-            // Check if we have any argument...
-            if (!iterate_args(&arg, &arglist, arglist_end))
+            reply_bool("pwm", "PWM", is_pwm);
+            reply_bool("pattern", "Pattern running", pattern_running);
+            if (is_pwm)
             {
-                printf("LED: Usage: LED SET <n> (0 <= n <= 255)\r\n");
-                return false;
+                reply_u8("duty", "Duty cycle", duty_on);
             }
-            // ...and check that it's a number between 0 and 255.
-            // We have to clear out `errno` so we can tell whether the
-            // conversion is valid.
-            errno = 0;
-            char *end_ptr = NULL;
-            int32_t converted = strtol(arg, &end_ptr, 10);
-            if (converted == 0)
+            else
             {
-                // We could either have our zero, or an error.
-                // Let's rule out the errors.
-                if (errno != 0)
-                {
-                    printf("LED: Usage: LED SET <n> (0 <= n <= 255)\r\n");
-                    return false;
-                }
-                if (end_ptr == arg)
-                {
-                    printf("LED: Usage: LED SET <n> (0 <= n <= 255)\r\n");
-                    return false;
-                }
-
-                // At this point we know that our output was zero, but it also
-                // was what we expected.
+                reply_bool("on", "LED", is_on);
             }
+            reply_u32("freq", "PWM frequency (Hz)", actual_frequency());
+            reply_u16("steps", "PWM steps", pwm_steps);
+        }
+        break;
+    case LED_FORM_BLINK:
+        blink((uint16_t) args->values[0].number,
+                (uint16_t) args->values[1].number,
+                (args->count > 2) ? (uint16_t) args->values[2].number
+                    : LED_PATTERN_FOREVER);
+        break;
+    case LED_FORM_BREATHE:
+        breathe((uint16_t) args->values[0].number);
+        break;
+    case LED_FORM_FADE:
+        fade((uint8_t) args->values[0].number,
+                (uint8_t) args->values[1].number,
+                (uint16_t) args->values[2].number);
+        break;
+    case LED_FORM_FREQ:
+        if (!set_frequency((uint16_t) args->values[0].number))
+        {
+            reply_error("%"PRId32" Hz isn't possible at %"PRIu32" Hz",
+                    args->values[0].number, clock_hz());
+            return COMMAND_FAILED;
+        }
+        break;
+    case LED_FORM_SET:
+        set_duty((uint8_t) args->values[0].number);
+        break;
+    }
+    return COMMAND_OK;
+}
 
-            // Now we check the range.
-            if (converted < 0)
-            {
-                printf("LED: Usage: LED SET <n> (0 <= n <= 255)\r\n");
-                return false;
-            }
-            if (converted > 255)
-            {
-                printf("LED: Usage: LED SET <n> (0 <= n <= 255)\r\n");
-                return false;
-            }
+static void set_led(bool on)
+{
+    stop_pattern();
+    // Hand the pin back to the port.
+    is_pwm = false;
+    TCA0.SPLIT.CTRLB &= ~TCA_SPLIT_HCMP2EN_bm;
+    if (on)
+    {
+        VPORTF.OUT |= PIN5_bm;
+    }
+    else
+    {
+        VPORTF.OUT &= ~PIN5_bm;
+    }
 
-            // And now we know that our argument can be used as a duty cycle
-            // value.
+    is_on = on;
+}
 
-            // Temporarily disable blink for the purpose of setting the new
-            // duty cycle.
-            is_blinking = false;
+// Scales the duty cycle, out of 256, to the steps the timer has.
+static uint8_t compare_value(uint8_t duty)
+{
+    return (uint8_t) (((uint16_t) duty * pwm_steps) / LED_PWM_MAX_STEPS);
+}
 
-            duty_on = (uint8_t) converted;
+static void set_duty(uint8_t duty)
+{
+    stop_pattern();
+    duty_on = duty;
+    // Split mode has no buffered compare registers, but an 8-bit write
+    // can't be torn, so at worst a single period comes out wrong.
+    TCA0.SPLIT.HCMP2 = compare_value(duty);
+    TCA0.SPLIT.CTRLB |= TCA_SPLIT_HCMP2EN_bm;
+    is_pwm = true;
+}
 
-            is_blinking = true;
+static void show_level(void)
+{
+    duty_on = gamma_table[level];
+    TCA0.SPLIT.HCMP2 = compare_value(duty_on);
+}
 
-            return true;
+// Moves on to the next keyframe which takes time, applying the ones which
+// don't on the way. Returns false once the pattern is over.
+static bool next_frame(void)
+{
+    for (;;)
+    {
+        if (++frame >= keyframe_count)
+        {
+            if ((runs_left != LED_PATTERN_FOREVER) && (--runs_left == 0))
+            {
+                return false;
+            }
+            frame = 0;
         }
-        else
+
+        const led_keyframe *k = &keyframes[frame];
+        if (k->ticks > 0)
         {
-            printf("LED: Unknown argument: %s\r\n", arg);
+            direction = (k->level >= level) ? 1 : -1;
+            distance = (k->level >= level) ? k->level - level
+                    : level - k->level;
+            frame_ticks = k->ticks;
+            ticks_left = k->ticks;
+            step_error = 0;
+            return true;
         }
+        level = k->level;
+        show_level();
     }
-    else
+}
+
+static void stop_pattern(void)
+{
+    RTC.PITINTCTRL = 0;
+    pattern_running = false;
+}
+
+// Runs the keyframes set up in `keyframes` `runs` times.
+static void start_pattern(uint8_t count, uint16_t runs)
+{
+    keyframe_count = count;
+    runs_left = runs;
+    // Patterns start from dark, unless their first keyframe jumps.
+    level = 0;
+    // So that the first frame is 0, without counting a run.
+    frame = UINT8_MAX;
+
+    TCA0.SPLIT.CTRLB |= TCA_SPLIT_HCMP2EN_bm;
+    is_pwm = true;
+
+    if (next_frame())
     {
-        printf("PWM enabled: %s\r\n", is_blinking ? "YES" : "NO");
-        if (is_blinking)
-        {
-            printf("Duty cycle: %"PRIu8"\r\n", duty_on);
-        }
-        else
+        pattern_running = true;
+        RTC.PITINTFLAGS = RTC_PI_bm;
+        RTC.PITINTCTRL = RTC_PI_bm;
+    }
+}
+
+// Rounds up, so that no step of a pattern takes no time at all.
+static uint16_t ms_to_ticks(uint16_t ms)
+{
+    return (uint16_t) (((uint32_t) ms * LED_PATTERN_TICK_HZ + 999) / 1000);
+}
+
+static void set_keyframe(uint8_t i, uint8_t level, uint16_t ms)
+{
+    keyframes[i].level = level;
+    keyframes[i].ticks = ms_to_ticks(ms);
+}
+
+static void blink(uint16_t on_ms, uint16_t off_ms, uint16_t count)
+{
+    stop_pattern();
+    set_keyframe(0, 255, 0);
+    set_keyframe(1, 255, on_ms);
+    set_keyframe(2, 0, 0);
+    set_keyframe(3, 0, off_ms);
+    start_pattern(4, count);
+}
+
+static void breathe(uint16_t ms)
+{
+    stop_pattern();
+    set_keyframe(0, 255, ms / 2);
+    set_keyframe(1, 0, ms - ms / 2);
+    start_pattern(2, LED_PATTERN_FOREVER);
+}
+
+static void fade(uint8_t from, uint8_t to, uint16_t ms)
+{
+    stop_pattern();
+    set_keyframe(0, from, 0);
+    set_keyframe(1, to, ms);
+    start_pattern(2, 1);
+}
+
+// Finds the smallest prescaler which gets `hz` within the 8-bit counter,
+// keeping as many steps as possible. Returns false if `hz` can't be had with
+// at least LED_PWM_MIN_STEPS steps.
+static bool compute_pwm(uint16_t hz, uint32_t clock, const prescaler **p,
+        uint16_t *steps)
+{
+    // Too slow for even the largest prescaler, unless something fits.
+    *p = &prescalers[ARRAY_LEN(prescalers) - 1];
+    *steps = LED_PWM_MAX_STEPS;
+    for (uint8_t i = 0; i < ARRAY_LEN(prescalers); ++i)
+    {
+        uint32_t ticks = clock / prescalers[i].division;
+        uint32_t n = (ticks + hz / 2) / hz;
+        if (n <= LED_PWM_MAX_STEPS)
         {
-            printf("Is on: %s\r\n", is_on ? "YES" : "NO");
+            *p = &prescalers[i];
+            *steps = (uint16_t) n;
+            return n >= LED_PWM_MIN_STEPS;
         }
     }
-    return true;
+    return false;
 }
 
-static void led_command_print_help_text(void)
+static void apply_pwm(void)
 {
-    printf("\tLED\tQuery LED brightness and ON/OFF state\r\n");
-    printf("\tLED [ON|OFF]\tTurn the LED on or off\r\n");
-    printf("\tLED SET <n>\tSet LED brightness (0 <= n <= 255)\r\n");
+    TCA0.SPLIT.CTRLA = 0;
+    TCA0.SPLIT.HPER = (uint8_t) (pwm_steps - 1);
+    TCA0.SPLIT.HCMP2 = compare_value(duty_on);
+    TCA0.SPLIT.HCNT = 0;
+    TCA0.SPLIT.CTRLA = pwm_prescaler->clksel | TCA_SPLIT_ENABLE_bm;
 }
 
-static void set_led(bool on)
+static bool set_frequency(uint16_t hz)
 {
-    is_blinking = false;
-    if (on)
+    const prescaler *p;
+    uint16_t steps;
+    if (!compute_pwm(hz, clock_hz(), &p, &steps))
     {
-        PORTF.OUTCLR = PIN5_bm;
+        return false;
     }
-    else
+
+    pwm_hz = hz;
+    pwm_prescaler = p;
+    pwm_steps = steps;
+    apply_pwm();
+    return true;
+}
+
+static uint32_t actual_frequency(void)
+{
+    return clock_hz() / pwm_prescaler->division / pwm_steps;
+}
+
+// Sets the timer up for `pwm_hz` if at all possible, otherwise for the
+// nearest frequency it can do.
+static void fit_frequency(void)
+{
+    if (!compute_pwm(pwm_hz, clock_hz(), &pwm_prescaler, &pwm_steps)
+            && (pwm_steps < LED_PWM_MIN_STEPS))
     {
-        PORTF.OUTSET = PIN5_bm;
+        pwm_steps = LED_PWM_MIN_STEPS;
     }
+    apply_pwm();
+}
 
-    is_on = on;
+void led_clock_changed(void)
+{
+    fit_frequency();
 }
 
 static void init_timer(void)
 {
-    // Enable overflow interrupt for timer
-    TCA0.SINGLE.INTCTRL = TCA_SINGLE_OVF_bm;
-    // Set as normal mode
-    TCA0.SINGLE.EVCTRL &= ~TCA_SINGLE_CNTEI_bm;
+    // Route the waveform outputs to port F, so WO5 lands on PF5.
+    PORTMUX.TCAROUTEA = (PORTMUX.TCAROUTEA & ~PORTMUX_TCA0_gm)
+            | PORTMUX_TCA0_PORTF_gc;
+
+    // The timer has to be stopped and reset before switching modes.
+    TCA0.SINGLE.CTRLA = 0;
+    TCA0.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESET_gc;
+    TCA0.SPLIT.CTRLD = TCA_SPLIT_SPLITM_bm;
 
-    // Set the duty cycle as to make the blinking somewhat useful for dimming.
-    //
-    // TODO: Figure out how to use TCA's PWM generation for this, while
-    // allowing for the easy turning on and off of the signal, and modifying
-    // of the duty cycle.
-    TCA0.SINGLE.PER = 0x0000;
+    // The high half runs the PWM by itself, so no interrupts are needed.
+    // The output only gets enabled once there's a duty cycle to drive.
+    fit_frequency();
+}
 
-    // Enable timer and set clock source to be system/256
-    TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV256_gc | TCA_SINGLE_ENABLE_bm;
+static void init_pattern_timer(void)
+{
+    // The RTC's clock has been set up by `ticks_init`. The periodic
+    // interrupt only gets enabled while a pattern runs.
+    while (RTC.PITSTATUS & RTC_CTRLBUSY_bm);
+    RTC.PITCTRLA = RTC_PERIOD_CYC128_gc | RTC_PITEN_bm;
 }
 
-ISR(TCA0_OVF_vect)
+ISR(RTC_PIT_vect)
 {
-    static uint8_t counter = 0;
-    // If we are to blink, let's blink
-    if (is_blinking)
+    RTC.PITINTFLAGS = RTC_PI_bm;
+
+    // While holding a level this is all there is to do.
+    if (distance > 0)
     {
-        // If we're on the "on" period, turn on the LED.
-        if (counter < duty_on)
-        {
-            PORTF.OUTCLR = PIN5_bm;
-        }
-        else
+        step_error += distance;
+        if (step_error >= frame_ticks)
         {
-            // Otherwise, turn it off.
-            PORTF.OUTSET = PIN5_bm;
+            do
+            {
+                step_error -= frame_ticks;
+                level += direction;
+            } while (step_error >= frame_ticks);
+            show_level();
         }
-        // Either way, increment the counter.
-        // It will just work since with unsigned ints, the standard
-        // says that no overflow is possible and everything wraps around
-        // neatly!
-        ++counter;
     }
 
-    // Clear interrupt flag
-    TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
-}
\ No newline at end of file
+    if ((--ticks_left == 0) && !next_frame())
+    {
+        stop_pattern();
+    }
+}
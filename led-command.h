@@ -16,6 +16,9 @@ extern "C" {
 
 extern const command led_cmd;
 
+// Keeps the PWM at the same frequency after the clock has changed.
+void led_clock_changed(void);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,560 @@
+/*
+ * File:   line-editor.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 22:20
+ */
+
+#include "line-editor.h"
+#include "ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static ring *input = NULL;
+
+// Where the echo goes. With echo off, everything the editor would draw is
+// thrown away instead.
+static FILE *out = NULL;
+
+#if LINE_EDITOR_IN_PLACE
+// The line lives in the receive ring, starting from `line_start`. Everything
+// from there up to `scan`, the next byte we haven't read yet, has been read
+// but not given back to the ring, so we're free to shuffle the line around in
+// it. Since every character we read adds at most one character to the line,
+// the line always fits.
+static uint8_t line_start = 0;
+static uint8_t scan = 0;
+// A line recalled from the history may well be longer than what's been read
+// since the line started, so it's edited here instead.
+static char recalled[LINE_EDITOR_HISTORY_LINE_SIZE];
+static bool editing_recalled = false;
+
+static char *line_char(size_t i)
+{
+    if (editing_recalled)
+    {
+        return &recalled[i];
+    }
+    return (char *) &input->data[(uint8_t)(line_start + i) & input->mask];
+}
+#define LINE(i) (*line_char(i))
+#else
+static char line[LINE_EDITOR_BUFFER_SIZE] = {'\0'};
+#define LINE(i) (line[(i)])
+#endif
+
+static size_t line_length = 0;
+// Where the next character gets inserted. Always kept in sync with where
+// the terminal's cursor is.
+static size_t cursor = 0;
+
+// Previous lines, stored in a ring. `history_next` is the slot the next line
+// will be written into.
+static char history[LINE_EDITOR_HISTORY_ENTRIES][LINE_EDITOR_HISTORY_LINE_SIZE];
+static uint8_t history_next = 0;
+static uint8_t history_count = 0;
+// How far back in the history we are while browsing with up and down.
+// Zero means we're editing a fresh line.
+static uint8_t history_browse = 0;
+
+// State for decoding the VT100 escape sequences sent by arrow keys and such.
+static enum
+{
+    ESCAPE_NONE,
+    ESCAPE_ESC,
+    // ESC [
+    ESCAPE_CSI,
+    // ESC O
+    ESCAPE_SS3,
+} escape_state = ESCAPE_NONE;
+static uint8_t escape_param = 0;
+
+// Used to swallow the LF of a CR LF pair so it doesn't end another line.
+static bool last_was_cr = false;
+
+void line_editor_init(ring *r)
+{
+    input = r;
+    if (out == NULL)
+    {
+        out = stdout;
+    }
+#if LINE_EDITOR_IN_PLACE
+    line_start = r->tail;
+    scan = r->tail;
+    editing_recalled = false;
+#endif
+}
+
+void line_editor_set_echo(bool echo)
+{
+    out = echo ? stdout : null_stream();
+}
+
+void line_editor_prompt(void)
+{
+    fprintf(out, "\r> ");
+}
+
+void line_editor_args(arg_list *args)
+{
+#if LINE_EDITOR_IN_PLACE
+    if (editing_recalled)
+    {
+        arg_list_init(args, recalled, &recalled[line_length], NULL, NULL);
+        return;
+    }
+
+    // The bytes up to `scan` are ours, so nobody else is going to touch them
+    // while the line is being parsed.
+    char *data = (char *) input->data;
+    size_t until_wrap = (size_t) input->mask + 1 - line_start;
+    // The byte after the line has to be in the same piece, since it gets
+    // overwritten with a NUL.
+    if (line_length < until_wrap)
+    {
+        arg_list_init(args, &data[line_start], &data[line_start + line_length],
+                NULL, NULL);
+    }
+    else
+    {
+        arg_list_init(args, &data[line_start], &data[input->mask + 1],
+                data, &data[line_length - until_wrap]);
+    }
+#else
+    arg_list_init(args, line, &line[line_length], NULL, NULL);
+#endif
+}
+
+void line_editor_clear(void)
+{
+    line_length = 0;
+    cursor = 0;
+#if LINE_EDITOR_IN_PLACE
+    // Hand everything we've read back to the ring.
+    editing_recalled = false;
+    line_start = scan;
+    ring_release(input, scan);
+#endif
+}
+
+bool line_editor_input_pending(void)
+{
+#if LINE_EDITOR_IN_PLACE
+    return scan != input->head;
+#else
+    return !ring_is_empty(input);
+#endif
+}
+
+static void print_range(size_t from, size_t to)
+{
+    for (size_t i = from; i < to; ++i)
+    {
+        putc(LINE(i), out);
+    }
+}
+
+static void cursor_left(size_t n)
+{
+    // A backspace is cheaper than an escape sequence for short hops.
+    if (n == 1)
+    {
+        putc('\b', out);
+    }
+    else if (n > 1)
+    {
+        fprintf(out, "\x1b[%uD", (unsigned) n);
+    }
+}
+
+static void cursor_right(size_t n)
+{
+    // Likewise, re-sending a few characters beats an escape sequence.
+    if (n < 4)
+    {
+        print_range(cursor, cursor + n);
+    }
+    else
+    {
+        fprintf(out, "\x1b[%uC", (unsigned) n);
+    }
+}
+
+// Sends the part of the line from the cursor to the end, and moves the
+// terminal's cursor back to where it was. `erased` is the number of
+// characters the line just got shorter by, which need to be blanked out.
+static void redraw_tail(size_t erased)
+{
+    print_range(cursor, line_length);
+    for (size_t i = 0; i < erased; ++i)
+    {
+        putc(' ', out);
+    }
+    cursor_left(line_length - cursor + erased);
+}
+
+// Whether there's no room for another character. Room is kept for the NUL
+// the parser adds after the line.
+static bool line_full(void)
+{
+#if LINE_EDITOR_IN_PLACE
+    // A line in the ring always fits, see above.
+    return editing_recalled
+            && (line_length + 1 >= LINE_EDITOR_HISTORY_LINE_SIZE);
+#else
+    return line_length + 1 >= LINE_EDITOR_BUFFER_SIZE;
+#endif
+}
+
+static void insert_char(char c)
+{
+    if (line_full())
+    {
+        // No room, ring the bell.
+        putc('\a', out);
+        return;
+    }
+
+    for (size_t i = line_length; i > cursor; --i)
+    {
+        LINE(i) = LINE(i - 1);
+    }
+    LINE(cursor) = c;
+    ++line_length;
+
+    // Echo the character, and if we're not at the end of the line, also
+    // whatever got shifted to the right of it.
+    putc(c, out);
+    ++cursor;
+    redraw_tail(0);
+}
+
+static void delete_at_cursor(void)
+{
+    if (cursor == line_length)
+    {
+        return;
+    }
+
+    for (size_t i = cursor; i + 1 < line_length; ++i)
+    {
+        LINE(i) = LINE(i + 1);
+    }
+    --line_length;
+    redraw_tail(1);
+}
+
+static void delete_before_cursor(void)
+{
+    if (cursor == 0)
+    {
+        return;
+    }
+
+    cursor_left(1);
+    --cursor;
+    delete_at_cursor();
+}
+
+static void move_to(size_t position)
+{
+    if (position < cursor)
+    {
+        cursor_left(cursor - position);
+    }
+    else
+    {
+        cursor_right(position - cursor);
+    }
+    cursor = position;
+}
+
+// Replaces the whole line, e.g. with one from the history.
+static void replace_line(const char *text)
+{
+    size_t old_length = line_length;
+
+    move_to(0);
+    line_length = strlen(text);
+    for (size_t i = 0; i < line_length; ++i)
+    {
+        LINE(i) = text[i];
+    }
+    print_range(0, line_length);
+    cursor = line_length;
+
+    if (line_length < old_length)
+    {
+        // Erase the leftovers of the old line.
+        fprintf(out, "\x1b[K");
+    }
+}
+
+static char *history_entry(uint8_t age)
+{
+    uint8_t slot = (history_next + LINE_EDITOR_HISTORY_ENTRIES - age)
+            % LINE_EDITOR_HISTORY_ENTRIES;
+    return history[slot];
+}
+
+static bool line_equals(const char *text)
+{
+    for (size_t i = 0; i < line_length; ++i)
+    {
+        if (LINE(i) != text[i])
+        {
+            return false;
+        }
+    }
+    return text[line_length] == '\0';
+}
+
+static void history_add(void)
+{
+    history_browse = 0;
+
+    if ((line_length == 0) || (line_length >= LINE_EDITOR_HISTORY_LINE_SIZE))
+    {
+        return;
+    }
+    // Repeating the same command doesn't need more than one entry.
+    if ((history_count > 0) && line_equals(history_entry(1)))
+    {
+        return;
+    }
+
+    char *entry = history[history_next];
+    for (size_t i = 0; i < line_length; ++i)
+    {
+        entry[i] = LINE(i);
+    }
+    entry[line_length] = '\0';
+    history_next = (history_next + 1) % LINE_EDITOR_HISTORY_ENTRIES;
+    if (history_count < LINE_EDITOR_HISTORY_ENTRIES)
+    {
+        ++history_count;
+    }
+}
+
+static void history_older(void)
+{
+    if (history_browse < history_count)
+    {
+        ++history_browse;
+#if LINE_EDITOR_IN_PLACE
+        editing_recalled = true;
+#endif
+        replace_line(history_entry(history_browse));
+    }
+}
+
+static void history_newer(void)
+{
+    if (history_browse > 0)
+    {
+        --history_browse;
+        if (history_browse > 0)
+        {
+            replace_line(history_entry(history_browse));
+            return;
+        }
+#if LINE_EDITOR_IN_PLACE
+        // Back to a fresh line, which starts out empty in the ring.
+        editing_recalled = false;
+#endif
+        replace_line("");
+    }
+}
+
+void line_editor_hide(void)
+{
+    fprintf(out, "\r\x1b[K");
+}
+
+void line_editor_redraw(void)
+{
+    line_editor_prompt();
+    print_range(0, line_length);
+    cursor_left(line_length - cursor);
+}
+
+// Handles the final character of an escape sequence.
+static void handle_escape(char c)
+{
+    switch (c)
+    {
+    case 'A':
+        history_older();
+        break;
+    case 'B':
+        history_newer();
+        break;
+    case 'C':
+        if (cursor < line_length)
+        {
+            move_to(cursor + 1);
+        }
+        break;
+    case 'D':
+        if (cursor > 0)
+        {
+            move_to(cursor - 1);
+        }
+        break;
+    case 'H':
+        move_to(0);
+        break;
+    case 'F':
+        move_to(line_length);
+        break;
+    case '~':
+        // ESC [ n ~ style keys, which differ between terminals.
+        switch (escape_param)
+        {
+        case 1:
+        case 7:
+            move_to(0);
+            break;
+        case 4:
+        case 8:
+            move_to(line_length);
+            break;
+        case 3:
+            delete_at_cursor();
+            break;
+        }
+        break;
+    }
+}
+
+static void finish_line(void)
+{
+    history_add();
+    fprintf(out, "\r\n");
+}
+
+// Handles a single character. Returns true if it finished the line.
+static bool feed(char c)
+{
+    bool was_cr = last_was_cr;
+    last_was_cr = false;
+
+    switch (escape_state)
+    {
+    case ESCAPE_ESC:
+        if (c == '[')
+        {
+            escape_state = ESCAPE_CSI;
+            escape_param = 0;
+        }
+        else if (c == 'O')
+        {
+            escape_state = ESCAPE_SS3;
+        }
+        else
+        {
+            escape_state = ESCAPE_NONE;
+        }
+        return false;
+    case ESCAPE_CSI:
+        if ((c >= '0') && (c <= '9'))
+        {
+            escape_param = escape_param * 10 + (c - '0');
+            return false;
+        }
+        // Fall through, since this is the final character.
+    case ESCAPE_SS3:
+        escape_state = ESCAPE_NONE;
+        handle_escape(c);
+        return false;
+    case ESCAPE_NONE:
+        break;
+    }
+
+    switch (c)
+    {
+    // Escape
+    case 0x1B:
+        escape_state = ESCAPE_ESC;
+        break;
+    // Newline
+    case 0x0D:
+        last_was_cr = true;
+        finish_line();
+        return true;
+    case 0x0A:
+        // CR LF only ends one line.
+        if (was_cr)
+        {
+            break;
+        }
+        finish_line();
+        return true;
+    // Backspace, either way the terminal wants to send it
+    case 0x7F:
+    case 0x08:
+        delete_before_cursor();
+        break;
+    // Ctrl-A and Ctrl-E
+    case 0x01:
+        move_to(0);
+        break;
+    case 0x05:
+        move_to(line_length);
+        break;
+    default:
+        // Ignore any other control characters.
+        if ((uint8_t) c >= 0x20)
+        {
+            insert_char(c);
+        }
+        break;
+    }
+    return false;
+}
+
+bool line_editor_poll(void)
+{
+    uint8_t c;
+#if LINE_EDITOR_IN_PLACE
+    while (ring_scan(input, &scan, &c))
+    {
+        if (feed(c))
+        {
+            return true;
+        }
+
+        // A recalled line doesn't need anything in the ring, so what's
+        // been read can go back right away.
+        if (editing_recalled)
+        {
+            line_start = scan;
+            ring_release(input, scan);
+        }
+
+        // Nothing we've read goes back to the ring before the line is
+        // finished, so a line filling the ring could never be. Throw it
+        // away rather than get stuck. With flow control the other end
+        // pauses well before the ring is full, so give up at half of it,
+        // below the high-water mark.
+        if (((uint8_t)(scan - line_start) & input->mask)
+                >= (input->mask + 1) / 2)
+        {
+            fprintf(out, "\a\r\n");
+            line_editor_clear();
+            line_editor_prompt();
+        }
+    }
+#else
+    while (ring_get(input, &c))
+    {
+        if (feed(c))
+        {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,82 @@
+/*
+ * File:   line-editor.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 22:20
+ */
+
+#ifndef LINE_EDITOR_H
+#define	LINE_EDITOR_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "util.h"
+
+// When enabled, lines are edited and parsed right where they were received
+// in the receive ring instead of being copied into a buffer of their own.
+// Lines are then limited to half the size of the receive ring. A line
+// recalled from the history can't go back into the ring, so it's edited in
+// a buffer of LINE_EDITOR_HISTORY_LINE_SIZE instead.
+#ifndef LINE_EDITOR_IN_PLACE
+#define LINE_EDITOR_IN_PLACE 1
+#endif
+
+#if !LINE_EDITOR_IN_PLACE
+// Size of the buffer holding the line being edited.
+#ifndef LINE_EDITOR_BUFFER_SIZE
+#define LINE_EDITOR_BUFFER_SIZE 128
+#endif
+#endif
+
+// The history keeps this many previous lines, each at most
+// `LINE_EDITOR_HISTORY_LINE_SIZE - 1` characters long. Longer lines simply
+// aren't remembered.
+#ifndef LINE_EDITOR_HISTORY_ENTRIES
+#define LINE_EDITOR_HISTORY_ENTRIES 4
+#endif
+#ifndef LINE_EDITOR_HISTORY_LINE_SIZE
+#define LINE_EDITOR_HISTORY_LINE_SIZE 64
+#endif
+
+struct RING;
+
+// Sets the ring the editor reads its input from. The editor becomes the
+// ring's consumer.
+void line_editor_init(struct RING *input);
+
+// Turns echoing what's typed, and the prompt, on or off. Keys still edit
+// the line, it just isn't shown. On by default.
+void line_editor_set_echo(bool echo);
+
+// Prints the prompt for a new line.
+void line_editor_prompt(void);
+
+// Handles the received characters, echoing only what changed on the
+// terminal. Returns true once the line has been finished with Enter, and
+// leaves anything after that unread.
+bool line_editor_poll(void);
+
+// Whether there's received input that hasn't been looked at yet.
+bool line_editor_input_pending(void);
+
+// Takes the prompt and the line being edited off the terminal, so something
+// else can be printed, and puts them back afterwards.
+void line_editor_hide(void);
+void line_editor_redraw(void);
+
+// Sets up `args` to parse the finished line in place.
+void line_editor_args(arg_list *args);
+
+// Forgets the current line so a new one can be started.
+void line_editor_clear(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LINE_EDITOR_H */
@@ -5,9 +5,6 @@
  * Created on 17 December 2020, 13:21
  */
 
-#define F_CPU 3333333
-#define BAUD_RATE(bd) ((float)(F_CPU * 64 / (16 * (float)(bd))) + 0.5)
-
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <stdio.h>
@@ -16,179 +13,157 @@
 #include <stdbool.h>
 
 #include "command.h"
+#include "adc-command.h"
+#include "line-editor.h"
+#include "protocol.h"
+#include "reply.h"
+#include "serial.h"
+#include "ticks.h"
+#include "clock.h"
 #include "util.h"
 
-// A 1 KiB buffer ought to be enough space for all the command needs.
-static char command_buffer[1024] = {'\0'};
-static char *command_buffer_end = &command_buffer[0];
-
-// A ring-buffer for the incoming characters.
-static volatile char input_buffer[1024] = {'\0'};
-static volatile size_t input_buffer_start = 0;
-static volatile size_t input_buffer_end = 0;
-
-static volatile bool has_command_ready = false;
-
-static bool command_buffer_updated = true;
-
-static void usart0_init(void);
-static int usart0_print_char(char c, FILE *stream);
-static char usart0_read_char(void);
-
-static void print_prompt(void);
+static bool has_command_ready = false;
 
 static void process_keys(void);
 
+static void sleep_until_input(void);
+
 static void init_commands(void);
 
+static void run_command(uint8_t argc, const char *const *argv);
+
 int main(void)
 {
-    usart0_init();
+    clock_init();
+    ticks_init();
+    serial_init();
+    line_editor_init(serial_rx_ring(serial_console));
     init_commands();
     sei();
     set_sleep_mode(SLPCTRL_SMODE_IDLE_gc);
+    line_editor_prompt();
     while (1)
     {
-        print_prompt();
-        sleep_mode();
-        process_keys();
+        serial_poll();
+        adc_poll();
+
+        if (protocol_is_binary())
+        {
+            protocol_poll();
+            if (!protocol_is_binary())
+            {
+                // The shell picks up right after the last frame.
+                line_editor_init(serial_rx_ring(serial_console));
+                line_editor_prompt();
+                continue;
+            }
+        }
+        else
+        {
+            process_keys();
+        }
 
         if (has_command_ready)
         {
-            printf("\r\n");
             has_command_ready = false;
 
-            char *command_name = command_buffer;
-            char *arglist = NULL;
-            iterate_args(&command_name, &arglist, command_buffer_end);
+            // The line is parsed right where the editor keeps it.
+            arg_list line;
+            line_editor_args(&line);
 
-            bool found_command = false;
-            for (const command **cmd = commands; *cmd != NULL; ++cmd)
+            const char *argv[ARGS_MAX];
+            uint8_t argc;
+            args_status parsed = tokenize_args(&line, argv, ARRAY_LEN(argv),
+                    &argc);
+            if (parsed != ARGS_OK)
             {
-                const command *c = *cmd;
-                if (command_match_name(c, command_name))
-                {
-                    found_command = true;
-
-                    bool success = c->execute(arglist, command_buffer_end);
-                    printf("%s\r\n", success ? "OK" : "ERROR");
-
-                    break;
-                }
+                // There's no telling which command it was meant for.
+                reply_begin("");
+                reply_error((parsed == ARGS_TOO_MANY)
+                        ? "Too many arguments" : "Argument too long");
+                reply_end(COMMAND_BAD_ARGUMENTS);
+            }
+            else if (argc > 0)
+            {
+                run_command(argc, argv);
+                // Changes to the link take effect before the prompt.
+                serial_poll();
             }
 
-            if (!found_command) {
-                printf("No such command: %s\r\n", command_name);
+            line_editor_clear();
+            if (!protocol_is_binary())
+            {
+                line_editor_prompt();
             }
 
-            command_buffer_end = &command_buffer[0];
-            *command_buffer_end = '\0';
+            // There might be more lines waiting already, so don't sleep
+            // before having a look.
+            continue;
         }
+
+        sleep_until_input();
     }
 }
 
 static void init_commands(void)
 {
+    // The lookups would quietly miss commands and keywords otherwise.
+    const command *unsorted = command_check_sorted();
+    if (unsorted != NULL)
+    {
+        printf("%s: Tables out of order\r\n", unsorted->name);
+    }
+
     for (const command **cmd = commands; *cmd != NULL; ++cmd)
     {
         (*cmd)->init();
     }
 }
 
-// Make sure that `printf` and friends can be used.
-static FILE usart0_stream = FDEV_SETUP_STREAM(usart0_print_char,
-        NULL, _FDEV_SETUP_WRITE);
-
-static void usart0_init(void)
-{
-    // Set pin 1 as receive and pin 0 as send
-    PORTA.DIRCLR = PIN1_bm;
-    PORTA.DIRSET = PIN0_bm;
-    
-    USART0_BAUD = (uint16_t)BAUD_RATE(9600);
-    
-    // Enable receiving and sending
-    USART0.CTRLB |= USART_RXEN_bm | USART_TXEN_bm;
-    // Also enable interrupts
-    USART0.CTRLA |= USART_RXCIE_bm;
-    
-    // And set the standard out appropriately so `printf` can be used.
-    stdout = &usart0_stream;
-}
-
-static int usart0_print_char(char c, FILE *stream)
+static void run_command(uint8_t argc, const char *const *argv)
 {
-    (void) stream;
-    // Wait until we can send the char...
-    while (!(USART0.STATUS & USART_DREIF_bm));
-    // ...and send it.
-    USART0.TXDATAL = c;
-    
-    return 0;
-}
+    const command *c = command_find(argv[0]);
+    if (c == NULL)
+    {
+        reply_begin(argv[0]);
+        reply_error("No such command");
+        reply_end(COMMAND_NO_SUCH_COMMAND);
+        return;
+    }
 
-static char usart0_read_char(void)
-{
-    // Wait until we can read the char...
-    while (!(USART0.STATUS & USART_DREIF_bm));
-    // ..and return it.
-    return USART0.RXDATAL;
+    command_args args;
+    command_status status = COMMAND_BAD_ARGUMENTS;
+    reply_begin(c->name);
+    if (command_parse(c, argc - 1, &argv[1], &args))
+    {
+        status = c->execute(&args);
+    }
+    reply_end(status);
 }
 
-static void print_prompt(void)
+static void sleep_until_input(void)
 {
-    if (command_buffer_updated)
+    // If a character arrived after `process_keys` had a look, going to sleep
+    // would leave it waiting for the next interrupt. So check again with
+    // interrupts off, and rely on the instruction after `sei` always being
+    // executed before any interrupt to not miss a wake-up.
+    cli();
+    if (!protocol_input_pending())
     {
-        printf("\r> ");
-        printf("%s", command_buffer);
-        command_buffer_updated = false;
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
     }
+    sei();
 }
 
 static void process_keys(void)
 {
-    while (input_buffer_start < input_buffer_end)
+    // Stop at the end of a line, so that anything typed after it stays
+    // queued until the command has run.
+    if (line_editor_poll())
     {
-        char c = input_buffer[input_buffer_start];
-
-        switch (c)
-        {
-        // Backspace
-        case 0x7F:
-            // Check whether we are already at the beginning of the command
-            // buffer so we don't affect things before it.
-            if (command_buffer_end == command_buffer)
-            {
-                break;
-            }
-
-            // Otherwise, back up with the end of the command,
-            // land remove character.
-            putchar(c);
-            --command_buffer_end;
-            *command_buffer_end = '\0';
-            break;
-        // Newline
-        case 0x0D:
-            has_command_ready = true;
-            break;
-        default:
-            // Add character to buffer, and terminate current command string.
-            *command_buffer_end = c;
-            ++command_buffer_end;
-            *command_buffer_end = '\0';
-            break;
-        }
-
-        input_buffer_start = (input_buffer_start + 1) % 1024;
-        command_buffer_updated = true;
+        has_command_ready = true;
     }
 }
-
-ISR(USART0_RXC_vect)
-{
-    char c = usart0_read_char();
-    // Store the newest character.
-    input_buffer[input_buffer_end] = c;
-    input_buffer_end = (input_buffer_end + 1) % 1024;
-}
@@ -0,0 +1,57 @@
+/*
+ * File:   pack.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:50
+ */
+
+#include "pack.h"
+
+static uint16_t difference(const uint16_t *samples, uint8_t i)
+{
+    return PACK_ZIGZAG((int16_t) (samples[i] - samples[i - 1]));
+}
+
+void pack_write(FILE *out, const uint16_t *samples, uint8_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The width is that of the largest difference, so they all fit.
+    uint16_t largest = 0;
+    for (uint8_t i = 1; i < count; ++i)
+    {
+        largest |= difference(samples, i);
+    }
+    uint8_t width = 0;
+    while ((width < PACK_MAX_WIDTH) && ((largest >> width) != 0))
+    {
+        ++width;
+    }
+
+    putc(count, out);
+    putc(width, out);
+    putc(samples[0] & 0xFF, out);
+    putc(samples[0] >> 8, out);
+
+    // Bits wait here until there's a whole byte of them.
+    uint32_t bits = 0;
+    uint8_t pending = 0;
+    for (uint8_t i = 1; i < count; ++i)
+    {
+        bits |= (uint32_t) difference(samples, i) << pending;
+        pending += width;
+        while (pending >= 8)
+        {
+            putc(bits & 0xFF, out);
+            bits >>= 8;
+            pending -= 8;
+        }
+    }
+    if (pending > 0)
+    {
+        putc(bits & 0xFF, out);
+    }
+}
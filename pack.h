@@ -0,0 +1,53 @@
+/*
+ * File:   pack.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:50
+ */
+
+#ifndef PACK_H
+#define	PACK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Compact encoding of blocks of samples, for getting more of them through a
+// slow link. Each sample but the first is sent as its difference to the
+// previous one, zigzagged so that small differences either way become
+// small numbers, and packed with just as many bits as the largest of the
+// block needs. A signal which changes slowly takes a few bits a sample.
+//
+// A block is
+//
+//     count, width, first sample (2 bytes), packed differences...
+//
+// where `count` is the number of samples, 1 to 255, and `width` the bits
+// of each of the `count - 1` differences, 0 to 16. The differences are
+// packed from the lowest bit of each byte up, and the last byte is padded
+// with zero bits. All of this is little-endian. The differences wrap around
+// at 16 bits, so any samples come back exactly. See tools/unpack-samples.c
+// for a decoder.
+
+#define PACK_HEADER_SIZE 4
+#define PACK_MAX_WIDTH 16
+
+// The size of a block of `count` samples packed `width` bits wide.
+#define PACK_BLOCK_SIZE(count, width) \
+    (PACK_HEADER_SIZE + (((uint16_t) (count) - 1) * (width) + 7) / 8)
+
+// Zigzags a difference, and back: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+#define PACK_ZIGZAG(d) ((uint16_t) (((uint16_t) (d) << 1) ^ -((d) < 0)))
+#define PACK_UNZIGZAG(z) ((int16_t) (((z) >> 1) ^ -((z) & 1)))
+
+// Writes the `count` samples as a block to `out`.
+void pack_write(FILE *out, const uint16_t *samples, uint8_t count);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PACK_H */
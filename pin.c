@@ -0,0 +1,78 @@
+/*
+ * File:   pin.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#include "pin.h"
+#include "serial.h"
+#include "util.h"
+#include <ctype.h>
+#include <stddef.h>
+
+// The pins each port has on the 48-pin ATmega4809.
+static const uint8_t port_pins[PIN_PORT_COUNT] = {
+    0xFF, 0x3F, 0xFF, 0xFF, 0x0F, 0x7F,
+};
+
+static const struct
+{
+    uint8_t pin;
+    const char *owner;
+} owners[] = {
+    { 0, "console", },
+    { 1, "console", },
+#if SERIAL_DATA_ENABLE
+    { 16, "data port", },
+#endif
+    { 45, "LED", },
+    { 46, "button", },
+};
+
+bool pin_parse(const char *text, uint8_t *pin)
+{
+    if ((toupper(text[0]) != 'P') || (text[1] == '\0')
+            || (text[2] < '0') || (text[2] > '7') || (text[3] != '\0'))
+    {
+        return false;
+    }
+
+    uint8_t port = toupper(text[1]) - 'A';
+    uint8_t bit = text[2] - '0';
+    if ((port >= PIN_PORT_COUNT) || !(port_pins[port] & (1 << bit)))
+    {
+        return false;
+    }
+
+    *pin = port * 8 + bit;
+    return true;
+}
+
+void pin_name(uint8_t pin, char *name)
+{
+    name[0] = 'P';
+    name[1] = 'A' + PIN_PORT(pin);
+    name[2] = '0' + PIN_BIT(pin);
+    name[3] = '\0';
+}
+
+const char *pin_owner(uint8_t pin)
+{
+    // The RTS pin is only driven while flow control uses it.
+    if ((serial_get_flow(serial_console) == SERIAL_FLOW_RTS)
+            && (&PIN_VPORT(pin) == &SERIAL_RTS_VPORT)
+            && (PIN_MASK(pin) == SERIAL_RTS_bm))
+    {
+        return "RTS output";
+    }
+
+    for (uint8_t i = 0; i < ARRAY_LEN(owners); ++i)
+    {
+        if (owners[i].pin == pin)
+        {
+            return owners[i].owner;
+        }
+    }
+    return NULL;
+}
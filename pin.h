@@ -0,0 +1,49 @@
+/*
+ * File:   pin.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#ifndef PIN_H
+#define	PIN_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+// Pins are numbered port * 8 + bit, so PA0 is 0 and PF6 is 46.
+#define PIN_PORT_COUNT 6
+#define PIN_PORT(pin) ((uint8_t) ((pin) >> 3))
+#define PIN_BIT(pin) ((uint8_t) ((pin) & 7))
+#define PIN_MASK(pin) ((uint8_t) (1 << PIN_BIT(pin)))
+
+// The virtual ports, which can be read and written with single
+// instructions. They follow each other in the I/O space.
+#define PIN_PORT_VPORT(port) ((&VPORTA)[(port)])
+#define PIN_VPORT(pin) PIN_PORT_VPORT(PIN_PORT(pin))
+
+// The full ports, only needed for the pin control registers, which the
+// virtual ports don't have.
+#define PIN_PORT_PORT(port) ((&PORTA)[(port)])
+#define PIN_CTRL(pin) ((&PIN_PORT_PORT(PIN_PORT(pin)).PIN0CTRL)[PIN_BIT(pin)])
+
+// Parses a pin name like PF5. Returns false if there's no such pin on this
+// chip.
+bool pin_parse(const char *text, uint8_t *pin);
+
+// Writes the name of the pin into `name`, which needs room for 4 characters.
+void pin_name(uint8_t pin, char *name);
+
+// What the pin is already used for, or NULL if it's free.
+const char *pin_owner(uint8_t pin);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PIN_H */
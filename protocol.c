@@ -0,0 +1,258 @@
+/*
+ * File:   protocol.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:25
+ */
+
+#include "protocol.h"
+#include "cobs.h"
+#include "command.h"
+#include "reply.h"
+#include "serial.h"
+#include "line-editor.h"
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+
+static bool is_binary = false;
+// Whether we've seen a frame boundary since switching.
+static bool in_sync = false;
+
+static uint8_t request[PROTOCOL_FRAME_SIZE];
+static cobs_decoder decoder;
+
+// Sequence number and status, the payload, and the CRC.
+static uint8_t response[2 + PROTOCOL_PAYLOAD_SIZE + 2];
+static size_t payload_length = 0;
+static bool truncated = false;
+
+static int capture_char(char c, FILE *stream);
+
+// While a command runs, whatever it prints ends up in the response.
+static FILE capture_stream = FDEV_SETUP_STREAM(capture_char,
+        NULL, _FDEV_SETUP_WRITE);
+
+void protocol_enter_binary(void)
+{
+    is_binary = true;
+    in_sync = false;
+    cobs_decoder_init(&decoder, request, sizeof(request));
+}
+
+bool protocol_is_binary(void)
+{
+    return is_binary;
+}
+
+bool protocol_input_pending(void)
+{
+    // The line editor keeps the line it's read in the ring until it's done
+    // with it, so only it knows what's new.
+    return is_binary ? serial_rx_pending(serial_console)
+            : line_editor_input_pending();
+}
+
+static int capture_char(char c, FILE *stream)
+{
+    (void) stream;
+
+    if (payload_length < PROTOCOL_PAYLOAD_SIZE)
+    {
+        response[2 + payload_length++] = (uint8_t) c;
+    }
+    else
+    {
+        truncated = true;
+    }
+    return 0;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc = _crc_xmodem_update(crc, data[i]);
+    }
+    return crc;
+}
+
+static void send_response(uint8_t seq, uint8_t status)
+{
+    response[0] = seq;
+    response[1] = status | (truncated ? PROTOCOL_TRUNCATED_bm : 0);
+
+    size_t length = 2 + payload_length;
+    uint16_t crc = crc16(response, length);
+    response[length++] = crc & 0xFF;
+    response[length++] = crc >> 8;
+
+    cobs_write(response, length, stdout);
+}
+
+// What the console had while an event is being captured.
+static FILE *event_console;
+static reply_format event_format;
+static uint8_t event_id;
+
+void protocol_begin_event(const command *c)
+{
+    event_id = 0;
+    for (const command **cmd = commands; *cmd != c; ++cmd)
+    {
+        ++event_id;
+    }
+
+    if (is_binary)
+    {
+        payload_length = 0;
+        truncated = false;
+        event_console = stdout;
+        event_format = reply_get_format();
+        stdout = &capture_stream;
+        reply_set_format(REPLY_BINARY);
+    }
+    else
+    {
+        line_editor_hide();
+    }
+    reply_begin(c->name);
+}
+
+void protocol_end_event(void)
+{
+    reply_end_event();
+    if (is_binary)
+    {
+        reply_set_format(event_format);
+        stdout = event_console;
+        send_response(event_id, PROTOCOL_EVENT);
+    }
+    else
+    {
+        line_editor_redraw();
+    }
+}
+
+static const command *command_by_id(uint8_t id)
+{
+    for (const command **cmd = commands; *cmd != NULL; ++cmd, --id)
+    {
+        if (id == 0)
+        {
+            return *cmd;
+        }
+    }
+    return NULL;
+}
+
+static void list_commands(void)
+{
+    for (const command **cmd = commands; *cmd != NULL; ++cmd)
+    {
+        if (cmd != commands)
+        {
+            putchar('\0');
+        }
+        printf("%s", (*cmd)->name);
+    }
+}
+
+// Runs the request in the decoder's buffer, and returns its status.
+static command_status run_request(size_t length)
+{
+    uint8_t id = request[1];
+
+    if (id == PROTOCOL_ID_LIST)
+    {
+        list_commands();
+        return COMMAND_OK;
+    }
+    if (id == PROTOCOL_ID_TEXT)
+    {
+        is_binary = false;
+        return COMMAND_OK;
+    }
+
+    const command *c = command_by_id(id);
+    if (c == NULL)
+    {
+        return COMMAND_NO_SUCH_COMMAND;
+    }
+
+    // The CRC isn't needed anymore, so its first byte can terminate the
+    // last argument.
+    size_t end = length - 2;
+    request[end] = '\0';
+
+    const char *argv[ARGS_MAX];
+    uint8_t argc = 0;
+    for (size_t i = 2; i < end; i += strlen((char *) &request[i]) + 1)
+    {
+        if (argc == ARRAY_LEN(argv))
+        {
+            reply_error("Too many arguments");
+            return COMMAND_BAD_ARGUMENTS;
+        }
+        argv[argc++] = (const char *) &request[i];
+    }
+
+    command_args args;
+    if (!command_parse(c, argc, argv, &args))
+    {
+        return COMMAND_BAD_ARGUMENTS;
+    }
+    return c->execute(&args);
+}
+
+static void handle_request(size_t length)
+{
+    payload_length = 0;
+    truncated = false;
+
+    // The smallest valid request is a sequence number, an ID and the CRC.
+    if ((length < 4) || (crc16(request, length - 2)
+            != (request[length - 2] | (request[length - 1] << 8))))
+    {
+        send_response(length > 0 ? request[0] : 0, PROTOCOL_BAD_FRAME);
+        return;
+    }
+
+    FILE *console = stdout;
+    reply_format format = reply_get_format();
+    stdout = &capture_stream;
+    reply_set_format(REPLY_BINARY);
+
+    command_status status = run_request(length);
+
+    reply_set_format(format);
+    stdout = console;
+
+    send_response(request[0], status);
+}
+
+void protocol_poll(void)
+{
+    char c;
+    while (is_binary && serial_read_char(serial_console, &c))
+    {
+        if (!in_sync)
+        {
+            in_sync = c == '\0';
+            continue;
+        }
+
+        switch (cobs_decode(&decoder, (uint8_t) c))
+        {
+        case COBS_FRAME:
+            handle_request(decoder.length);
+            break;
+        case COBS_ERROR:
+            handle_request(0);
+            break;
+        case COBS_MORE:
+            break;
+        }
+    }
+}
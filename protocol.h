@@ -0,0 +1,90 @@
+/*
+ * File:   protocol.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:25
+ */
+
+#ifndef PROTOCOL_H
+#define	PROTOCOL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The binary protocol, for programs rather than people. It runs over the
+// same serial link as the shell, which switches to it with the BINARY
+// command.
+//
+// Every frame is COBS encoded and ends with a zero byte, see cobs.h. Bytes
+// are discarded until the first zero after switching, so a host should
+// start by sending one. Decoded, a request is
+//
+//     seq, id, arguments..., crc (2 bytes)
+//
+// where `id` is the index of the command in the sorted command list, and
+// the arguments are the same text as in the shell, separated by zero
+// bytes. The response is
+//
+//     seq, status, payload..., crc (2 bytes)
+//
+// with `seq` copied from the request, and `status` a `command_status` or
+// PROTOCOL_BAD_FRAME. Between responses there may also be events, which
+// nobody asked for, like alerts. Their status is PROTOCOL_EVENT and `seq`
+// the ID of the command they're from. The payload holds the values the
+// command reported, in binary (see reply.h), and whatever else it printed,
+// like error messages. The CRC is CRC-16/CCITT-FALSE over everything before
+// it, low byte first.
+
+// The largest decoded request and response payload.
+#ifndef PROTOCOL_FRAME_SIZE
+#define PROTOCOL_FRAME_SIZE 64
+#endif
+#ifndef PROTOCOL_PAYLOAD_SIZE
+#define PROTOCOL_PAYLOAD_SIZE 128
+#endif
+
+// Reserved command IDs.
+// Responds with the names of the commands, by ID, separated by zeros.
+#define PROTOCOL_ID_LIST 0xFE
+// Responds, then switches back to the shell.
+#define PROTOCOL_ID_TEXT 0xFF
+
+// The request was cut short or its CRC didn't match. Its `seq` can't be
+// trusted either.
+#define PROTOCOL_BAD_FRAME 0x7F
+
+// The status of an event.
+#define PROTOCOL_EVENT 0x7E
+
+// Set in the status when the payload didn't fit and was cut short.
+#define PROTOCOL_TRUNCATED_bm 0x80
+
+// Switches to the binary protocol once the current command is done.
+void protocol_enter_binary(void);
+bool protocol_is_binary(void);
+
+// Whether something new has arrived on the console, in either mode. Lets
+// long-running commands stop on a key press.
+bool protocol_input_pending(void);
+
+struct COMMAND;
+
+// Reports an event of command `c` in whichever mode the console is in. The
+// values are written in between with the functions of reply.h. Only for
+// the main loop, between commands.
+void protocol_begin_event(const struct COMMAND *c);
+void protocol_end_event(void);
+
+// Handles the received bytes, running the command of each complete request.
+// Stops early when switched back to the shell, leaving the rest to it.
+void protocol_poll(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROTOCOL_H */
@@ -0,0 +1,123 @@
+/*
+ * File:   pwm-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#include "pwm-command.h"
+#include "pwm.h"
+#include "pin.h"
+#include "util.h"
+#include "reply.h"
+#include <ctype.h>
+
+static void pwm_command_init(void);
+static command_status pwm_command_execute(const command_args *args);
+
+enum
+{
+    PWM_FORM_SET,
+    PWM_FORM_STOP,
+};
+
+static const arg_spec set_args[] = {
+    ARG_SPEC_PIN("pin"),
+    ARG_SPEC_INT("duty", 0, 255),
+};
+
+static const arg_spec stop_args[] = {
+    ARG_SPEC_PIN("pin"),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form pwm_forms[] = {
+    [PWM_FORM_SET] = {
+        .args = set_args, .count = 2,
+        .help = "Lists the channels, or dims a pin by duty / 256",
+    },
+    [PWM_FORM_STOP] = {
+        .keyword = "STOP", .args = stop_args, .required = 1, .count = 1,
+        .help = "Stops dimming a pin, leaving it low",
+    },
+};
+
+const command pwm_cmd = {
+    .name = "PWM",
+    .short_help_blurb = "Dims any pins with software PWM",
+
+    .forms = pwm_forms,
+    .form_count = ARRAY_LEN(pwm_forms),
+
+    .init = &pwm_command_init,
+    .execute = &pwm_command_execute,
+};
+
+static void pwm_command_init(void)
+{
+    pwm_init();
+}
+
+static void report_channel(uint8_t pin, uint8_t duty)
+{
+    char label[4];
+    char key[4];
+    pin_name(pin, label);
+    for (uint8_t i = 0; i < sizeof(key); ++i)
+    {
+        key[i] = tolower(label[i]);
+    }
+    reply_u8(key, label, duty);
+}
+
+static command_status pwm_command_execute(const command_args *args)
+{
+    uint8_t pin = (args->count > 0) ? args->values[0].number : 0;
+
+    if (args->form == PWM_FORM_STOP)
+    {
+        pwm_release(pin);
+        return COMMAND_OK;
+    }
+
+    if (args->count == 2)
+    {
+        const char *owner = pin_owner(pin);
+        if (owner != NULL)
+        {
+            reply_error("The pin is taken by the %s", owner);
+            return COMMAND_FAILED;
+        }
+        if (!pwm_set(pin, args->values[1].number))
+        {
+            reply_error("All %u channels are taken", PWM_CHANNELS);
+            return COMMAND_FAILED;
+        }
+        return COMMAND_OK;
+    }
+
+    bool found = false;
+    for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+    {
+        uint8_t channel_pin;
+        uint8_t duty;
+        if (pwm_get(i, &channel_pin, &duty)
+                && ((args->count == 0) || (channel_pin == pin)))
+        {
+            report_channel(channel_pin, duty);
+            found = true;
+        }
+    }
+
+    if (args->count == 0)
+    {
+        reply_u8("interrupts", "Interrupts per period",
+                pwm_interrupts_per_period());
+    }
+    else if (!found)
+    {
+        reply_error("The pin isn't being dimmed");
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   pwm-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#ifndef PWM_COMMAND_H
+#define	PWM_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command pwm_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PWM_COMMAND_H */
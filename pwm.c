@@ -0,0 +1,388 @@
+/*
+ * File:   pwm.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#include "pwm.h"
+#include "pin.h"
+#include "clock.h"
+#include "util.h"
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#define NO_PIN 0xFF
+
+typedef struct PWM_CHANNEL {
+    uint8_t pin;
+    uint8_t duty;
+} pwm_channel;
+
+typedef struct PWM_EDGE {
+    // Timer clocks since the previous edge, or since the start of the period
+    // for the first one. Zero for another port switching at the same time.
+    uint16_t delay;
+    uint8_t port;
+    // The pins to switch off.
+    uint8_t mask;
+} pwm_edge;
+
+typedef struct PWM_SCHEDULE {
+    // The pins to switch on at the start of the period, for each port.
+    uint8_t on[PIN_PORT_COUNT];
+    pwm_edge edges[PWM_CHANNELS];
+    uint8_t edge_count;
+    // Timer clocks from the last edge to the end of the period.
+    uint16_t tail;
+} pwm_schedule;
+
+static pwm_channel channels[PWM_CHANNELS];
+
+// The interrupt runs `active`, and takes `pending` over at the start of the
+// next period, so that changes never cut a period short. The other one of
+// the two is free to be written.
+static pwm_schedule schedules[2];
+static pwm_schedule *volatile active = &schedules[0];
+static pwm_schedule *volatile pending = NULL;
+
+#define PERIOD_START 0xFF
+// The edge the timer is counting towards, only touched by the interrupt
+// while the timer runs.
+static uint8_t next_edge = PERIOD_START;
+
+static bool running = false;
+// In timer clocks.
+static uint16_t period;
+static uint16_t min_gap;
+static uint8_t clksel;
+
+static void compute_period(void)
+{
+    uint32_t cycles = clock_hz() / PWM_HZ;
+    uint8_t division = 1;
+    clksel = TCB_CLKSEL_CLKDIV1_gc;
+    if (cycles > UINT16_MAX)
+    {
+        division = 2;
+        clksel = TCB_CLKSEL_CLKDIV2_gc;
+    }
+
+    uint32_t clocks = cycles / division;
+    // Too slow a clock to reach the frequency just makes it lower.
+    period = (clocks > UINT16_MAX) ? UINT16_MAX : (uint16_t) clocks;
+    min_gap = PWM_MIN_EDGE_CYCLES / division;
+}
+
+void pwm_init(void)
+{
+    for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+    {
+        channels[i].pin = NO_PIN;
+    }
+    compute_period();
+
+    TCB1.CTRLB = TCB_CNTMODE_INT_gc;
+    TCB1.INTCTRL = TCB_CAPT_bm;
+}
+
+// Adds the falling edge of a channel at `at` to the sorted list of edges.
+static void add_edge(pwm_schedule *s, uint16_t *times, uint16_t at,
+        uint8_t port, uint8_t mask)
+{
+    uint8_t i = s->edge_count;
+    while ((i > 0) && (times[i - 1] > at))
+    {
+        times[i] = times[i - 1];
+        s->edges[i] = s->edges[i - 1];
+        --i;
+    }
+    times[i] = at;
+    s->edges[i].port = port;
+    s->edges[i].mask = mask;
+    ++s->edge_count;
+}
+
+// Merges edges too close to each other, and ones on the same port at the
+// same time, and turns the times into delays.
+static void merge_edges(pwm_schedule *s, uint16_t *times)
+{
+    uint8_t count = 0;
+    uint16_t previous = 0;
+    uint8_t group = 0;
+    for (uint8_t i = 0; i < s->edge_count; ++i)
+    {
+        uint16_t at = times[i];
+        if ((count > 0) && (at - previous < min_gap))
+        {
+            at = previous;
+        }
+        else
+        {
+            group = count;
+        }
+
+        // Another pin of a port already switching at this time.
+        bool merged = false;
+        for (uint8_t j = group; j < count; ++j)
+        {
+            if (s->edges[j].port == s->edges[i].port)
+            {
+                s->edges[j].mask |= s->edges[i].mask;
+                merged = true;
+                break;
+            }
+        }
+        if (!merged)
+        {
+            s->edges[count].port = s->edges[i].port;
+            s->edges[count].mask = s->edges[i].mask;
+            s->edges[count].delay = at - previous;
+            ++count;
+        }
+        previous = at;
+    }
+
+    s->edge_count = count;
+    s->tail = period - previous;
+}
+
+static void start_timer(pwm_schedule *s)
+{
+    active = s;
+    next_edge = PERIOD_START;
+    // Start the first period right away.
+    TCB1.CNT = 0;
+    TCB1.CCMP = min_gap;
+    TCB1.INTFLAGS = TCB_CAPT_bm;
+    TCB1.CTRLA = clksel | TCB_ENABLE_bm;
+    running = true;
+}
+
+static void stop_timer(void)
+{
+    running = false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TCB1.CTRLA = 0;
+        // An edge which was already due mustn't run anymore.
+        TCB1.INTFLAGS = TCB_CAPT_bm;
+        // The timer may have stopped in the middle of a period.
+        for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+        {
+            if (channels[i].pin != NO_PIN)
+            {
+                PIN_VPORT(channels[i].pin).OUT &= ~PIN_MASK(channels[i].pin);
+            }
+        }
+    }
+}
+
+static void update_schedule(void)
+{
+    // Once there's nothing pending the interrupt leaves the other schedule
+    // alone, so it can be written.
+    pwm_schedule *s;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        pending = NULL;
+        s = (active == &schedules[0]) ? &schedules[1] : &schedules[0];
+    }
+
+    uint16_t times[PWM_CHANNELS];
+    memset(s->on, 0, sizeof(s->on));
+    s->edge_count = 0;
+    for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+    {
+        const pwm_channel *c = &channels[i];
+        if ((c->pin == NO_PIN) || (c->duty == 0))
+        {
+            continue;
+        }
+
+        uint16_t at = (uint16_t) (((uint32_t) period * c->duty) >> 8);
+        // Keep the interrupt enough time both after the start of the
+        // period and before the next one.
+        if (at < min_gap)
+        {
+            at = min_gap;
+        }
+        if (at > period - min_gap)
+        {
+            at = period - min_gap;
+        }
+
+        s->on[PIN_PORT(c->pin)] |= PIN_MASK(c->pin);
+        add_edge(s, times, at, PIN_PORT(c->pin), PIN_MASK(c->pin));
+    }
+    merge_edges(s, times);
+
+    if (s->edge_count == 0)
+    {
+        if (running)
+        {
+            stop_timer();
+        }
+    }
+    else if (!running)
+    {
+        start_timer(s);
+    }
+    else
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            pending = s;
+        }
+    }
+}
+
+static pwm_channel *find_channel(uint8_t pin)
+{
+    for (uint8_t i = 0; i < PWM_CHANNELS; ++i)
+    {
+        if (channels[i].pin == pin)
+        {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+bool pwm_set(uint8_t pin, uint8_t duty)
+{
+    pwm_channel *c = find_channel(pin);
+    if (c == NULL)
+    {
+        c = find_channel(NO_PIN);
+        if (c == NULL)
+        {
+            return false;
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            PIN_VPORT(pin).OUT &= ~PIN_MASK(pin);
+        }
+        PIN_VPORT(pin).DIR |= PIN_MASK(pin);
+        c->pin = pin;
+    }
+
+    c->duty = duty;
+    update_schedule();
+    return true;
+}
+
+void pwm_release(uint8_t pin)
+{
+    pwm_channel *c = find_channel(pin);
+    if (c == NULL)
+    {
+        return;
+    }
+
+    c->pin = NO_PIN;
+    update_schedule();
+    // The schedule still running may switch the pin on until the end of
+    // this period, but not after.
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        PIN_VPORT(pin).OUT &= ~PIN_MASK(pin);
+    }
+}
+
+bool pwm_get(uint8_t i, uint8_t *pin, uint8_t *duty)
+{
+    if ((i >= PWM_CHANNELS) || (channels[i].pin == NO_PIN))
+    {
+        return false;
+    }
+    *pin = channels[i].pin;
+    *duty = channels[i].duty;
+    return true;
+}
+
+uint8_t pwm_interrupts_per_period(void)
+{
+    if (!running)
+    {
+        return 0;
+    }
+
+    const pwm_schedule *s;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        s = (pending != NULL) ? pending : active;
+    }
+    uint8_t count = 1;
+    for (uint8_t i = 0; i < s->edge_count; ++i)
+    {
+        if (s->edges[i].delay > 0)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void pwm_clock_changed(void)
+{
+    compute_period();
+    if (running)
+    {
+        TCB1.CTRLA = clksel | TCB_ENABLE_bm;
+    }
+    update_schedule();
+}
+
+ISR(TCB1_INT_vect)
+{
+    TCB1.INTFLAGS = TCB_CAPT_bm;
+
+    const pwm_schedule *s;
+    uint8_t i = next_edge;
+    if (i == PERIOD_START)
+    {
+        if (pending != NULL)
+        {
+            active = pending;
+            pending = NULL;
+        }
+        s = active;
+        for (uint8_t port = 0; port < PIN_PORT_COUNT; ++port)
+        {
+            if (s->on[port] != 0)
+            {
+                PIN_PORT_VPORT(port).OUT |= s->on[port];
+            }
+        }
+        i = 0;
+    }
+    else
+    {
+        s = active;
+        // Along with the other ports switching at the same time.
+        do
+        {
+            const pwm_edge *e = &s->edges[i];
+            PIN_PORT_VPORT(e->port).OUT &= ~e->mask;
+            ++i;
+        } while ((i < s->edge_count) && (s->edges[i].delay == 0));
+    }
+
+    // The counter started over when it matched, so the compare value is
+    // the time until the next edge.
+    if (i < s->edge_count)
+    {
+        TCB1.CCMP = s->edges[i].delay - 1;
+        next_edge = i;
+    }
+    else
+    {
+        TCB1.CCMP = s->tail - 1;
+        next_edge = PERIOD_START;
+    }
+}
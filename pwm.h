@@ -0,0 +1,64 @@
+/*
+ * File:   pwm.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 06:10
+ */
+
+#ifndef PWM_H
+#define	PWM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Software PWM on any pins, timed by TCB1.
+//
+// Rather than comparing each channel against a counter on every tick, the
+// edges of a period are worked out beforehand and sorted, with the pins
+// switching at the same time gathered into a mask per port. The interrupt
+// then only fires once per distinct edge, writing whole masks at a time.
+
+#ifndef PWM_CHANNELS
+#define PWM_CHANNELS 8
+#endif
+
+// The frequency of the PWM, the same for all channels.
+#ifndef PWM_HZ
+#define PWM_HZ 250
+#endif
+
+// Edges closer to each other than this many CPU cycles get merged into one,
+// so the interrupt can keep up with them. Shortens the longer pulse a tad.
+#ifndef PWM_MIN_EDGE_CYCLES
+#define PWM_MIN_EDGE_CYCLES 160
+#endif
+
+void pwm_init(void);
+
+// Drives `pin` with a duty cycle of duty / 256, taking a channel for it if
+// it doesn't have one already. Returns false if all the channels are taken.
+bool pwm_set(uint8_t pin, uint8_t duty);
+
+// Frees the pin's channel, if it has one, leaving the pin low.
+void pwm_release(uint8_t pin);
+
+// Gives the pin and duty cycle of channel `i`. Returns false if the channel
+// isn't in use.
+bool pwm_get(uint8_t i, uint8_t *pin, uint8_t *duty);
+
+// How many times the interrupt fires in a period, the start included. Zero
+// when the timer is stopped because no pin has anything to do.
+uint8_t pwm_interrupts_per_period(void);
+
+// Keeps the frequency after the clock has changed. See clock.h.
+void pwm_clock_changed(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PWM_H */
@@ -0,0 +1,342 @@
+/*
+ * File:   reply.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:10
+ */
+
+#include "reply.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+static int put_error_char(char c, FILE *stream);
+
+// Escapes what's written to it into the current command's line.
+static FILE error_stream = FDEV_SETUP_STREAM(put_error_char,
+        NULL, _FDEV_SETUP_WRITE);
+
+static reply_format current_format = REPLY_HUMAN;
+
+// The machine-readable line of the current command is started only once
+// there's something to put on it.
+static const char *record_name = "";
+static bool record_open = false;
+// Whether the line already has an error on it.
+static bool record_has_error = false;
+
+// By `command_status`.
+static const char *const status_names[] = {
+    "ok",
+    "bad_arguments",
+    "failed",
+    "no_such_command",
+};
+
+void reply_set_format(reply_format format)
+{
+    current_format = format;
+}
+
+reply_format reply_get_format(void)
+{
+    return current_format;
+}
+
+void reply_begin(const char *command_name)
+{
+    record_name = command_name;
+    record_open = false;
+    record_has_error = false;
+}
+
+static void open_record(void)
+{
+    if (record_open)
+    {
+        return;
+    }
+    record_open = true;
+
+    if (current_format == REPLY_JSON)
+    {
+        printf("{\"command\":\"");
+    }
+    // The name may be whatever was typed in place of a command, so only
+    // the characters that need no quoting in any of the formats are kept.
+    for (const char *c = record_name; *c != '\0'; ++c)
+    {
+        putchar((isalnum(*c) || (*c == '-') || (*c == '_'))
+                ? tolower(*c) : '?');
+    }
+    if (current_format == REPLY_JSON)
+    {
+        putchar('"');
+    }
+}
+
+void reply_end(command_status status)
+{
+    const char *name = (status < ARRAY_LEN(status_names))
+            ? status_names[status] : "?";
+
+    switch (current_format)
+    {
+    case REPLY_HUMAN:
+        printf("%s\r\n", (status == COMMAND_OK) ? "OK" : "ERROR");
+        break;
+    case REPLY_TERSE:
+        open_record();
+        printf(" status=%s\r\n", name);
+        break;
+    case REPLY_CSV:
+        open_record();
+        printf(",%s\r\n", name);
+        break;
+    case REPLY_JSON:
+        open_record();
+        printf(",\"status\":\"%s\"}\r\n", name);
+        break;
+    case REPLY_BINARY:
+        // The protocol sends the status in the frame.
+        break;
+    }
+}
+
+void reply_end_event(void)
+{
+    switch (current_format)
+    {
+    case REPLY_HUMAN:
+        printf("EVENT\r\n");
+        break;
+    case REPLY_TERSE:
+        open_record();
+        printf(" status=event\r\n");
+        break;
+    case REPLY_CSV:
+        open_record();
+        printf(",event\r\n");
+        break;
+    case REPLY_JSON:
+        open_record();
+        printf(",\"status\":\"event\"}\r\n");
+        break;
+    case REPLY_BINARY:
+        break;
+    }
+}
+
+// Prints whatever goes before a value in the text formats, so that only the
+// value itself is left to print.
+static void begin_value(const char *key, const char *label)
+{
+    switch (current_format)
+    {
+    case REPLY_HUMAN:
+        printf("%s: ", label);
+        break;
+    case REPLY_TERSE:
+        open_record();
+        printf(" %s=", key);
+        break;
+    case REPLY_CSV:
+        open_record();
+        putchar(',');
+        break;
+    case REPLY_JSON:
+        open_record();
+        printf(",\"%s\":", key);
+        break;
+    case REPLY_BINARY:
+        break;
+    }
+}
+
+static void end_value(void)
+{
+    if (current_format == REPLY_HUMAN)
+    {
+        printf("\r\n");
+    }
+}
+
+// Quoting is the same for TERSE and JSON, while CSV doubles the quotes. Line
+// endings and such would break the line, so they're either escaped or
+// turned into spaces.
+static int put_error_char(char c, FILE *stream)
+{
+    (void) stream;
+    if ((uint8_t) c < 0x20)
+    {
+        if (current_format == REPLY_JSON)
+        {
+            printf("\\u%04x", (unsigned) c);
+        }
+        else
+        {
+            putchar(' ');
+        }
+        return 0;
+    }
+
+    if (c == '"')
+    {
+        putchar((current_format == REPLY_CSV) ? '"' : '\\');
+    }
+    else if ((c == '\\') && (current_format != REPLY_CSV))
+    {
+        putchar('\\');
+    }
+    putchar(c);
+    return 0;
+}
+
+FILE *reply_begin_error(void)
+{
+    switch (current_format)
+    {
+    case REPLY_HUMAN:
+        if (*record_name != '\0')
+        {
+            printf("%s: ", record_name);
+        }
+        return stdout;
+    case REPLY_BINARY:
+        return stdout;
+    default:
+        break;
+    }
+
+    if (record_has_error)
+    {
+        return null_stream();
+    }
+    begin_value("error", NULL);
+    putchar('"');
+    return &error_stream;
+}
+
+void reply_end_error(void)
+{
+    switch (current_format)
+    {
+    case REPLY_HUMAN:
+        printf("\r\n");
+        break;
+    case REPLY_BINARY:
+        break;
+    default:
+        if (!record_has_error)
+        {
+            record_has_error = true;
+            putchar('"');
+        }
+        break;
+    }
+}
+
+void reply_error(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(reply_begin_error(), format, args);
+    va_end(args);
+    reply_end_error();
+}
+
+static void put_bytes(uint32_t value, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        putchar((char) (value & 0xFF));
+        value >>= 8;
+    }
+}
+
+void reply_u8(const char *key, const char *label, uint8_t value)
+{
+    if (current_format == REPLY_BINARY)
+    {
+        put_bytes(value, sizeof(value));
+        return;
+    }
+    begin_value(key, label);
+    printf("%"PRIu8, value);
+    end_value();
+}
+
+void reply_u16(const char *key, const char *label, uint16_t value)
+{
+    if (current_format == REPLY_BINARY)
+    {
+        put_bytes(value, sizeof(value));
+        return;
+    }
+    begin_value(key, label);
+    printf("%"PRIu16, value);
+    end_value();
+}
+
+void reply_i16(const char *key, const char *label, int16_t value)
+{
+    if (current_format == REPLY_BINARY)
+    {
+        put_bytes((uint16_t) value, sizeof(value));
+        return;
+    }
+    begin_value(key, label);
+    printf("%"PRId16, value);
+    end_value();
+}
+
+void reply_u32(const char *key, const char *label, uint32_t value)
+{
+    if (current_format == REPLY_BINARY)
+    {
+        put_bytes(value, sizeof(value));
+        return;
+    }
+    begin_value(key, label);
+    printf("%"PRIu32, value);
+    end_value();
+}
+
+void reply_bool(const char *key, const char *label, bool value)
+{
+    const char *text;
+    switch (current_format)
+    {
+    case REPLY_BINARY:
+        put_bytes(value, 1);
+        return;
+    case REPLY_HUMAN:
+        text = value ? "ON" : "OFF";
+        break;
+    case REPLY_JSON:
+        text = value ? "true" : "false";
+        break;
+    default:
+        text = value ? "1" : "0";
+        break;
+    }
+    begin_value(key, label);
+    printf("%s", text);
+    end_value();
+}
+
+void reply_keyword(const char *key, const char *label, const keyword *table,
+        size_t count, uint8_t value)
+{
+    if (current_format == REPLY_BINARY)
+    {
+        put_bytes(value, sizeof(value));
+        return;
+    }
+    const char *name = keyword_name(table, count, value);
+    begin_value(key, label);
+    printf((current_format == REPLY_JSON) ? "\"%s\"" : "%s",
+            (name != NULL) ? name : "?");
+    end_value();
+}
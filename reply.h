@@ -0,0 +1,84 @@
+/*
+ * File:   reply.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 01:10
+ */
+
+#ifndef REPLY_H
+#define	REPLY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "command.h"
+#include "keyword.h"
+
+// How commands report the values they read, and how they went.
+typedef enum REPLY_FORMAT {
+    // A "label: value" line for each value, then OK or ERROR.
+    REPLY_HUMAN,
+    // One line per command, like `adc channel=6 value=512 status=ok`.
+    REPLY_TERSE,
+    // One line per command, like `adc,6,512,ok`.
+    REPLY_CSV,
+    // One object per line, like
+    // `{"command":"adc","channel":6,"value":512,"status":"ok"}`.
+    REPLY_JSON,
+    // The bare values, little-endian, one after another. Used within the
+    // responses of the binary protocol, see protocol.h.
+    REPLY_BINARY,
+} reply_format;
+
+void reply_set_format(reply_format format);
+reply_format reply_get_format(void);
+
+// Starts the reply of a command. The machine-readable formats name the line
+// after it.
+void reply_begin(const char *command_name);
+
+// Finishes the reply with the status of the command.
+void reply_end(command_status status);
+
+// Finishes an unsolicited report, like an alert, instead of the reply of a
+// command. It's told apart by its status, `event`.
+void reply_end_event(void);
+
+// Explains why the command failed, or how it's used. People get the message
+// on a line of its own, after the command's name. The machine-readable
+// formats get it as the `error` field of the command's line, quoted and
+// escaped as the format needs, and only the first message of a command is
+// kept there. In binary it's the bare text.
+//
+// The message is written to the stream `reply_begin_error` gives, without a
+// line ending, and finished with `reply_end_error`.
+FILE *reply_begin_error(void);
+void reply_end_error(void);
+// The same for a message which takes a single printf.
+void reply_error(const char *format, ...);
+
+// Each of these reports a single value. `key` names it in the
+// machine-readable formats, and `label` for people.
+//
+// In binary the value takes as many bytes as its type. A boolean is a byte
+// of 0 or 1, and a keyword the byte of its value, even though the text
+// formats show its name.
+void reply_u8(const char *key, const char *label, uint8_t value);
+void reply_u16(const char *key, const char *label, uint16_t value);
+void reply_i16(const char *key, const char *label, int16_t value);
+void reply_u32(const char *key, const char *label, uint32_t value);
+void reply_bool(const char *key, const char *label, bool value);
+void reply_keyword(const char *key, const char *label, const keyword *table,
+        size_t count, uint8_t value);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* REPLY_H */
@@ -11,16 +11,23 @@
 #include <avr/wdt.h>
 
 static void reset_command_init(void);
-static bool reset_command_execute(char *arglist, const char *arglist_end);
-static void reset_command_print_help_text(void);
+static command_status reset_command_execute(const command_args *args);
+
+static const command_form reset_forms[] = {
+    {
+        .help = "Resets this microcontroller",
+    },
+};
 
 const command reset_cmd = {
     .name = "RESET",
     .short_help_blurb = "Reset the microcontroller",
 
+    .forms = reset_forms,
+    .form_count = ARRAY_LEN(reset_forms),
+
     .init = &reset_command_init,
     .execute = &reset_command_execute,
-    .print_help_text = &reset_command_print_help_text,
 };
 
 // Disable watchdog at the start
@@ -36,17 +43,12 @@ void reset_command_init(void)
     // All the necessary stuff is done in wdt_init.
 }
 
-bool reset_command_execute(char *arglist, const char *arglist_end)
+command_status reset_command_execute(const command_args *args)
 {
-    (void) arglist;
-    (void) arglist_end;
+    (void) args;
 
     // TODO: Figure out why this isn't resetting!!
     wdt_enable(WDTO_15MS);
 
-    return true;
+    return COMMAND_OK;
 }
-void reset_command_print_help_text(void)
-{
-    printf("\tRESET\tResets this microcontroller\r\n");
-}
\ No newline at end of file
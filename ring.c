@@ -0,0 +1,99 @@
+/*
+ * File:   ring.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 23:05
+ */
+
+#include "ring.h"
+#include <util/atomic.h>
+
+bool ring_put(ring *r, uint8_t c)
+{
+    uint8_t head = r->head;
+    uint8_t next_head = (head + 1) & r->mask;
+    if (next_head == r->tail)
+    {
+        ++r->overruns;
+        return false;
+    }
+
+    r->data[head] = c;
+    // Only publish the byte once it's actually in the buffer.
+    r->head = next_head;
+
+    uint8_t count = (next_head - r->tail) & r->mask;
+    if (count > r->high_water)
+    {
+        r->high_water = count;
+    }
+    return true;
+}
+
+bool ring_get(ring *r, uint8_t *c)
+{
+    uint8_t tail = r->tail;
+    if (tail == r->head)
+    {
+        return false;
+    }
+
+    *c = r->data[tail];
+    // Only give the slot back once we've read it.
+    r->tail = (tail + 1) & r->mask;
+    return true;
+}
+
+bool ring_scan(const ring *r, uint8_t *index, uint8_t *c)
+{
+    uint8_t i = *index;
+    if (i == r->head)
+    {
+        return false;
+    }
+
+    *c = r->data[i];
+    *index = (i + 1) & r->mask;
+    return true;
+}
+
+void ring_release(ring *r, uint8_t index)
+{
+    r->tail = index & r->mask;
+}
+
+uint8_t ring_count(const ring *r)
+{
+    return (r->head - r->tail) & r->mask;
+}
+
+uint8_t ring_free(const ring *r)
+{
+    return r->mask - ring_count(r);
+}
+
+bool ring_is_empty(const ring *r)
+{
+    return r->head == r->tail;
+}
+
+void ring_get_stats(ring *r, ring_stats *stats)
+{
+    // The producer is usually an ISR, and the overrun counter is wider than
+    // a byte.
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats->overruns = r->overruns;
+        stats->high_water = r->high_water;
+    }
+    stats->capacity = r->mask;
+}
+
+void ring_clear_stats(ring *r)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        r->overruns = 0;
+        r->high_water = 0;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * File:   ring.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 23:05
+ */
+
+#ifndef RING_H
+#define	RING_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A single-producer single-consumer byte ring-buffer, meant for passing data
+// between an ISR and the main loop without disabling interrupts.
+//
+// The size has to be a power of two no larger than 256, so the indices fit
+// in a byte (which the AVR reads and writes atomically) and wrapping is just
+// a mask. One slot is always left empty to tell a full ring from an empty
+// one, so a ring can hold `size - 1` bytes.
+//
+// Only the producer may touch `head`, and only the consumer `tail`. Each
+// side publishes its index only after it's done with the data, so the other
+// side never sees a half-written or half-read slot.
+typedef struct RING {
+    volatile uint8_t *data;
+    uint8_t mask;
+    volatile uint8_t head;
+    volatile uint8_t tail;
+
+    // Statistics, only updated by the producer.
+    // Bytes that didn't fit and were thrown away.
+    uint32_t overruns;
+    // The fullest the ring has been.
+    uint8_t high_water;
+} ring;
+
+typedef struct RING_STATS {
+    uint32_t overruns;
+    uint8_t high_water;
+    uint8_t capacity;
+} ring_stats;
+
+// Defines a static ring called `name` with storage for `size` bytes. Fails
+// to compile if `size` isn't a power of two between 2 and 256.
+#define RING_DEFINE(name, size) \
+    typedef char name ## _size_must_be_a_power_of_two_up_to_256[ \
+        ((size) >= 2 && (size) <= 256 && ((size) & ((size) - 1)) == 0) \
+            ? 1 : -1]; \
+    static volatile uint8_t name ## _data[(size)]; \
+    static ring name = { .data = name ## _data, .mask = (size) - 1, }
+
+// Producer side. Returns false, and counts an overrun, if the ring is full.
+bool ring_put(ring *r, uint8_t c);
+
+// Consumer side. Returns false if the ring is empty.
+bool ring_get(ring *r, uint8_t *c);
+
+// Consumer side, for using the data in place instead of copying it out.
+// Reads the byte at `*index`, which should start out as `r->tail`, and
+// advances the index, but doesn't give the slot back to the producer.
+// Until then the consumer is free to modify everything it has scanned.
+// Returns false if there's nothing more to scan.
+bool ring_scan(const ring *r, uint8_t *index, uint8_t *c);
+
+// Gives every slot before `index` back to the producer.
+void ring_release(ring *r, uint8_t index);
+
+// Either side can ask these, but the answer is only exact for the consumer
+// (for `ring_count`) or the producer (for `ring_free`).
+uint8_t ring_count(const ring *r);
+uint8_t ring_free(const ring *r);
+
+bool ring_is_empty(const ring *r);
+
+// Reads and resets the statistics without racing the producer.
+void ring_get_stats(ring *r, ring_stats *stats);
+void ring_clear_stats(ring *r);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* RING_H */
@@ -0,0 +1,122 @@
+/*
+ * File:   serial-command.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 21:55
+ */
+
+#include "serial-command.h"
+#include "serial.h"
+#include "util.h"
+#include "keyword.h"
+#include "reply.h"
+
+static void serial_command_init(void);
+static command_status serial_command_execute(const command_args *args);
+
+static const keyword tx_args[] = {
+    { .name = "BLOCK", .value = SERIAL_TX_BLOCK, },
+    { .name = "DROPNEW", .value = SERIAL_TX_DROP_NEWEST, },
+    { .name = "DROPOLD", .value = SERIAL_TX_DROP_OLDEST, },
+};
+
+static const keyword flow_args[] = {
+    { .name = "NONE", .value = SERIAL_FLOW_NONE, },
+    { .name = "RTS", .value = SERIAL_FLOW_RTS, },
+    { .name = "XONXOFF", .value = SERIAL_FLOW_XONXOFF, },
+};
+
+enum
+{
+    SERIAL_FORM_SHOW,
+    SERIAL_FORM_CLEAR,
+    SERIAL_FORM_FLOW,
+    SERIAL_FORM_TX,
+};
+
+static const arg_spec serial_tx_args[] = {
+    ARG_SPEC_ENUM(tx_args),
+};
+
+static const arg_spec serial_flow_args[] = {
+    ARG_SPEC_ENUM(flow_args),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form serial_forms[] = {
+    [SERIAL_FORM_SHOW] = {
+        .help = "Prints the serial link statistics",
+    },
+    [SERIAL_FORM_CLEAR] = {
+        .keyword = "CLEAR",
+        .help = "Resets the statistics",
+    },
+    [SERIAL_FORM_FLOW] = {
+        .keyword = "FLOW", .args = serial_flow_args, .required = 1,
+        .count = 1,
+        .help = "Sets the receive flow control, XONXOFF not with BINARY",
+    },
+    [SERIAL_FORM_TX] = {
+        .keyword = "TX", .args = serial_tx_args, .required = 1, .count = 1,
+        .help = "Sets what happens when output overflows",
+    },
+};
+
+const command serial_cmd = {
+    .name = "SERIAL",
+    .short_help_blurb = "Displays and configures the serial link",
+
+    .forms = serial_forms,
+    .form_count = ARRAY_LEN(serial_forms),
+
+    .init = &serial_command_init,
+    .execute = &serial_command_execute,
+};
+
+static void serial_command_init(void)
+{
+}
+
+static command_status serial_command_execute(const command_args *args)
+{
+    switch (args->form)
+    {
+    case SERIAL_FORM_CLEAR:
+        serial_clear_tx_stats(serial_console);
+        serial_clear_rx_stats(serial_console);
+        break;
+    case SERIAL_FORM_TX:
+        serial_set_tx_policy(serial_console,
+                (serial_tx_policy) args->values[0].number);
+        break;
+    case SERIAL_FORM_FLOW:
+        serial_set_flow(serial_console, (serial_flow) args->values[0].number);
+        break;
+    default:
+    {
+        reply_keyword("policy", "TX overflow policy", tx_args,
+                ARRAY_LEN(tx_args), serial_get_tx_policy(serial_console));
+
+        serial_tx_stats tx_stats;
+        serial_get_tx_stats(serial_console, &tx_stats);
+        reply_u32("dropped", "TX bytes dropped", tx_stats.dropped);
+        reply_u32("blocked", "TX bytes blocked", tx_stats.blocked);
+
+        serial_rx_stats rx_stats;
+        serial_get_rx_stats(serial_console, &rx_stats);
+        reply_u32("overruns", "RX buffer overruns", rx_stats.overruns);
+        reply_u32("hw_overruns", "RX hardware overruns",
+                rx_stats.hw_overruns);
+        reply_u32("framing_errors", "RX framing errors",
+                rx_stats.framing_errors);
+        reply_u8("high_water", "RX buffer high water",
+                rx_stats.high_water);
+        reply_u8("capacity", "RX buffer capacity", rx_stats.capacity);
+        reply_keyword("flow", "RX flow control", flow_args,
+                ARRAY_LEN(flow_args), serial_get_flow(serial_console));
+        reply_u32("throttles", "RX flow pauses", rx_stats.throttles);
+        break;
+    }
+    }
+    return COMMAND_OK;
+}
@@ -0,0 +1,23 @@
+/*
+ * File:   serial-command.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 21:55
+ */
+
+#ifndef SERIAL_COMMAND_H
+#define	SERIAL_COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "command.h"
+
+extern const command serial_cmd;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SERIAL_COMMAND_H */
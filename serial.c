@@ -0,0 +1,559 @@
+/*
+ * File:   serial.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 21:30
+ */
+
+#include "serial.h"
+#include "ring.h"
+#include "ticks.h"
+#include "clock.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct SERIAL_PORT {
+    USART_t *usart;
+    // Filled by the receive complete interrupt and drained by the main
+    // loop. NULL if the port only sends.
+    ring *rx;
+    // Filled by writing to `stream` and drained by the data register empty
+    // interrupt.
+    ring *tx;
+    FILE stream;
+
+    serial_tx_policy tx_policy;
+    serial_tx_stats tx_stats;
+    volatile uint32_t rx_hw_overruns;
+    volatile uint32_t rx_framing_errors;
+
+    serial_flow flow;
+    // Whether the other end has been asked to pause.
+    volatile bool throttled;
+    volatile uint32_t throttles;
+    // Sent ahead of everything in `tx` while `tx_priority_pending` is set.
+    // For XON and XOFF, which can't wait their turn.
+    volatile uint8_t tx_priority;
+    volatile bool tx_priority_pending;
+    // Set whenever a byte is handed to the USART, so that `serial_flush`
+    // knows whether there's anything to wait for.
+    volatile bool tx_started;
+
+    serial_baud baud;
+    serial_baud pending_baud;
+    bool baud_pending;
+    // Cleared by the receive interrupt on the first valid byte after a
+    // change.
+    volatile bool awaiting_valid_byte;
+    uint32_t fallback_deadline;
+};
+
+static int serial_print_char(char c, FILE *stream);
+
+RING_DEFINE(console_rx_ring, SERIAL_RX_BUFFER_SIZE);
+RING_DEFINE(console_tx_ring, SERIAL_TX_BUFFER_SIZE);
+
+static serial_port console = {
+    .usart = &USART0,
+    .rx = &console_rx_ring,
+    .tx = &console_tx_ring,
+    .stream = FDEV_SETUP_STREAM(serial_print_char, NULL, _FDEV_SETUP_WRITE),
+    .tx_policy = SERIAL_TX_DEFAULT_POLICY,
+    .flow = SERIAL_FLOW_DEFAULT,
+};
+
+serial_port *const serial_console = &console;
+
+#if SERIAL_DATA_ENABLE
+RING_DEFINE(data_tx_ring, SERIAL_DATA_TX_BUFFER_SIZE);
+
+static serial_port data = {
+    .usart = &USART1,
+    .tx = &data_tx_ring,
+    .stream = FDEV_SETUP_STREAM(serial_print_char, NULL, _FDEV_SETUP_WRITE),
+    .tx_policy = SERIAL_DATA_TX_DEFAULT_POLICY,
+};
+
+serial_port *const serial_data = &data;
+#else
+serial_port *const serial_data = NULL;
+#endif
+
+#define XON 0x11
+#define XOFF 0x13
+
+static void apply_baud(serial_port *port, const serial_baud *baud);
+
+static void port_init(serial_port *port)
+{
+    fdev_set_udata(&port->stream, port);
+
+    serial_baud baud;
+    serial_compute_baud(SERIAL_DEFAULT_BAUD, clock_hz(), &baud);
+    apply_baud(port, &baud);
+
+    // The data register empty interrupt only gets enabled while there is
+    // something to send.
+    port->usart->CTRLB |= USART_TXEN_bm;
+    if (port->rx != NULL)
+    {
+        port->usart->CTRLB |= USART_RXEN_bm;
+        port->usart->CTRLA |= USART_RXCIE_bm;
+    }
+}
+
+void serial_init(void)
+{
+    // Set pin 1 as receive and pin 0 as send
+    PORTA.DIRCLR = PIN1_bm;
+    PORTA.DIRSET = PIN0_bm;
+    port_init(&console);
+    // Ready to receive.
+    SERIAL_RTS_VPORT.OUT &= ~SERIAL_RTS_bm;
+    if (console.flow == SERIAL_FLOW_RTS)
+    {
+        SERIAL_RTS_VPORT.DIR |= SERIAL_RTS_bm;
+    }
+
+#if SERIAL_DATA_ENABLE
+    // USART1 sends on PC0 by default.
+    PORTC.DIRSET = PIN0_bm;
+    port_init(&data);
+#endif
+
+    // And set the standard out appropriately so `printf` can be used.
+    stdout = &console.stream;
+}
+
+FILE *serial_stream(serial_port *port)
+{
+    return &port->stream;
+}
+
+bool serial_compute_baud(uint32_t rate, uint32_t clock_hz,
+        serial_baud *baud)
+{
+    baud->rate = rate;
+    // Stays zero if the rate can't be reached at all.
+    baud->actual = 0;
+    baud->error = 0;
+    if (rate == 0)
+    {
+        return false;
+    }
+
+    // BAUD = 64 * clock / (S * rate), S being the samples per bit. The
+    // register has to be at least 64, so go to double speed before that.
+    uint32_t scaled = 4 * clock_hz;
+    uint32_t divider = (scaled + rate / 2) / rate;
+    baud->double_speed = divider < 64;
+    if (baud->double_speed)
+    {
+        scaled = 8 * clock_hz;
+        divider = (scaled + rate / 2) / rate;
+    }
+    if ((divider < 64) || (divider > UINT16_MAX))
+    {
+        return false;
+    }
+
+    baud->divider = divider;
+    baud->actual = (scaled + divider / 2) / divider;
+    // With at least 64 in the divider, it's never off by more than a
+    // percent or so, so this can't overflow.
+    baud->error = ((int32_t) baud->actual - (int32_t) rate) * 10000
+            / (int32_t) rate;
+    return abs(baud->error) <= SERIAL_BAUD_TOLERANCE;
+}
+
+void serial_request_baud(serial_port *port, const serial_baud *baud)
+{
+    port->pending_baud = *baud;
+    port->baud_pending = true;
+}
+
+void serial_get_baud(serial_port *port, serial_baud *baud)
+{
+    *baud = port->baud;
+}
+
+static void apply_baud(serial_port *port, const serial_baud *baud)
+{
+    USART_t *usart = port->usart;
+    usart->CTRLB = (usart->CTRLB & ~USART_RXMODE_gm) | (baud->double_speed
+            ? USART_RXMODE_CLK2X_gc : USART_RXMODE_NORMAL_gc);
+    usart->BAUD = baud->divider;
+    port->baud = *baud;
+}
+
+static void send_priority(serial_port *port, uint8_t c)
+{
+    port->tx_priority = c;
+    port->tx_priority_pending = true;
+    port->usart->CTRLA |= USART_DREIE_bm;
+}
+
+// Asks the other end to pause. Called with interrupts off.
+static void throttle(serial_port *port)
+{
+    port->throttled = true;
+    ++port->throttles;
+    if (port->flow == SERIAL_FLOW_XONXOFF)
+    {
+        send_priority(port, XOFF);
+    }
+    else if (port->flow == SERIAL_FLOW_RTS)
+    {
+        SERIAL_RTS_VPORT.OUT |= SERIAL_RTS_bm;
+    }
+}
+
+// Lets the other end go on. Called with interrupts off.
+static void unthrottle(serial_port *port)
+{
+    port->throttled = false;
+    if (port->flow == SERIAL_FLOW_XONXOFF)
+    {
+        send_priority(port, XON);
+    }
+    else if (port->flow == SERIAL_FLOW_RTS)
+    {
+        SERIAL_RTS_VPORT.OUT &= ~SERIAL_RTS_bm;
+    }
+}
+
+void serial_set_flow(serial_port *port, serial_flow flow)
+{
+    if (port->rx == NULL)
+    {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // Don't leave the other end waiting for a signal which won't come.
+        if (port->throttled)
+        {
+            unthrottle(port);
+        }
+        port->flow = flow;
+    }
+
+    if (flow == SERIAL_FLOW_RTS)
+    {
+        SERIAL_RTS_VPORT.DIR |= SERIAL_RTS_bm;
+    }
+    else
+    {
+        SERIAL_RTS_VPORT.DIR &= ~SERIAL_RTS_bm;
+    }
+}
+
+serial_flow serial_get_flow(serial_port *port)
+{
+    return port->flow;
+}
+
+static void poll_port(serial_port *port)
+{
+    if (port->throttled && (ring_count(port->rx) <= SERIAL_RX_LOW_WATER))
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            unthrottle(port);
+        }
+    }
+
+    if (port->baud_pending)
+    {
+        port->baud_pending = false;
+        // The other end expects the reply to the change at the old rate.
+        serial_flush(port);
+        apply_baud(port, &port->pending_baud);
+
+        if ((port->rx != NULL) && (port->baud.rate != SERIAL_DEFAULT_BAUD))
+        {
+            port->fallback_deadline = ticks_now()
+                    + (uint32_t) SERIAL_BAUD_FALLBACK_SECONDS
+                    * TICKS_PER_SECOND;
+            port->awaiting_valid_byte = true;
+        }
+        else
+        {
+            port->awaiting_valid_byte = false;
+        }
+    }
+    else if (port->awaiting_valid_byte
+            && ticks_passed(port->fallback_deadline))
+    {
+        port->awaiting_valid_byte = false;
+
+        serial_baud fallback;
+        serial_compute_baud(SERIAL_DEFAULT_BAUD, clock_hz(), &fallback);
+        apply_baud(port, &fallback);
+    }
+}
+
+void serial_poll(void)
+{
+    poll_port(&console);
+#if SERIAL_DATA_ENABLE
+    poll_port(&data);
+#endif
+}
+
+static void port_clock_changed(serial_port *port)
+{
+    serial_baud baud;
+    if (!serial_compute_baud(port->baud.rate, clock_hz(), &baud))
+    {
+        serial_compute_baud(SERIAL_DEFAULT_BAUD, clock_hz(), &baud);
+    }
+    apply_baud(port, &baud);
+
+    // A change still waiting has to be worked out again, too.
+    if (port->baud_pending && !serial_compute_baud(port->pending_baud.rate,
+            clock_hz(), &port->pending_baud))
+    {
+        port->baud_pending = false;
+    }
+}
+
+void serial_clock_changed(void)
+{
+    port_clock_changed(&console);
+#if SERIAL_DATA_ENABLE
+    port_clock_changed(&data);
+#endif
+}
+
+void serial_set_tx_policy(serial_port *port, serial_tx_policy policy)
+{
+    port->tx_policy = policy;
+}
+
+serial_tx_policy serial_get_tx_policy(serial_port *port)
+{
+    return port->tx_policy;
+}
+
+void serial_get_tx_stats(serial_port *port, serial_tx_stats *stats)
+{
+    *stats = port->tx_stats;
+}
+
+void serial_clear_tx_stats(serial_port *port)
+{
+    port->tx_stats.dropped = 0;
+    port->tx_stats.blocked = 0;
+}
+
+bool serial_read_char(serial_port *port, char *c)
+{
+    return (port->rx != NULL) && ring_get(port->rx, (uint8_t *) c);
+}
+
+bool serial_rx_pending(serial_port *port)
+{
+    return (port->rx != NULL) && !ring_is_empty(port->rx);
+}
+
+struct RING *serial_rx_ring(serial_port *port)
+{
+    return port->rx;
+}
+
+void serial_get_rx_stats(serial_port *port, serial_rx_stats *stats)
+{
+    ring_stats ring = {0};
+    if (port->rx != NULL)
+    {
+        ring_get_stats(port->rx, &ring);
+    }
+
+    stats->overruns = ring.overruns;
+    stats->high_water = ring.high_water;
+    stats->capacity = ring.capacity;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stats->hw_overruns = port->rx_hw_overruns;
+        stats->framing_errors = port->rx_framing_errors;
+        stats->throttles = port->throttles;
+    }
+}
+
+void serial_clear_rx_stats(serial_port *port)
+{
+    if (port->rx != NULL)
+    {
+        ring_clear_stats(port->rx);
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        port->rx_hw_overruns = 0;
+        port->rx_framing_errors = 0;
+        port->throttles = 0;
+    }
+}
+
+// Sends the oldest buffered byte by polling. Only used when we have to wait
+// for room with interrupts disabled, since then the ISR can't do it for us.
+static void drain_one(serial_port *port)
+{
+    uint8_t c;
+    if (ring_get(port->tx, &c))
+    {
+        while (!(port->usart->STATUS & USART_DREIF_bm));
+        port->usart->STATUS = USART_TXCIF_bm;
+        port->usart->TXDATAL = c;
+        port->tx_started = true;
+    }
+}
+
+void serial_flush(serial_port *port)
+{
+    while (!ring_is_empty(port->tx))
+    {
+        if (!(SREG & CPU_I_bm))
+        {
+            drain_one(port);
+        }
+    }
+    // The last byte may still be on its way out.
+    if (port->tx_started)
+    {
+        while (!(port->usart->STATUS & USART_TXCIF_bm));
+        port->tx_started = false;
+    }
+}
+
+void serial_flush_all(void)
+{
+    serial_flush(&console);
+#if SERIAL_DATA_ENABLE
+    serial_flush(&data);
+#endif
+}
+
+static int serial_print_char(char c, FILE *stream)
+{
+    serial_port *port = fdev_get_udata(stream);
+    ring *tx = port->tx;
+
+    if (ring_free(tx) == 0)
+    {
+        // The buffer is full, so act according to the policy.
+        switch (port->tx_policy)
+        {
+        case SERIAL_TX_DROP_NEWEST:
+            ++port->tx_stats.dropped;
+            return 0;
+        case SERIAL_TX_DROP_OLDEST:
+            // Taking from the ring is the ISR's job, so it must not run
+            // while we do it. It might also have made room in the meantime.
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                uint8_t oldest;
+                if ((ring_free(tx) == 0) && ring_get(tx, &oldest))
+                {
+                    ++port->tx_stats.dropped;
+                }
+            }
+            break;
+        case SERIAL_TX_BLOCK:
+        default:
+            ++port->tx_stats.blocked;
+            while (ring_free(tx) == 0)
+            {
+                if (!(SREG & CPU_I_bm))
+                {
+                    drain_one(port);
+                }
+            }
+            break;
+        }
+    }
+
+    ring_put(tx, c);
+    // Now that there is something to send, let the ISR know about it.
+    port->usart->CTRLA |= USART_DREIE_bm;
+
+    return 0;
+}
+
+static void receive(serial_port *port)
+{
+    // The error flags have to be read before the data itself.
+    uint8_t status = port->usart->RXDATAH;
+    uint8_t c = port->usart->RXDATAL;
+
+    if (status & USART_BUFOVF_bm)
+    {
+        ++port->rx_hw_overruns;
+    }
+    if (status & USART_FERR_bm)
+    {
+        // Most likely sent at another baud rate, so it's garbage.
+        ++port->rx_framing_errors;
+        return;
+    }
+    port->awaiting_valid_byte = false;
+    // A full ring counts the overrun by itself.
+    ring_put(port->rx, c);
+
+    if ((port->flow != SERIAL_FLOW_NONE) && !port->throttled
+            && (ring_count(port->rx) >= SERIAL_RX_HIGH_WATER))
+    {
+        throttle(port);
+    }
+}
+
+static void send_next(serial_port *port)
+{
+    uint8_t c;
+    bool have_byte = true;
+    if (port->tx_priority_pending)
+    {
+        c = port->tx_priority;
+        port->tx_priority_pending = false;
+    }
+    else
+    {
+        have_byte = ring_get(port->tx, &c);
+    }
+
+    if (have_byte)
+    {
+        // Writing the flag clears it, so it tells when this byte is done.
+        port->usart->STATUS = USART_TXCIF_bm;
+        port->usart->TXDATAL = c;
+        port->tx_started = true;
+    }
+
+    // Once the buffer runs dry there's no point in getting interrupted
+    // anymore.
+    if (ring_is_empty(port->tx) && !port->tx_priority_pending)
+    {
+        port->usart->CTRLA &= ~USART_DREIE_bm;
+    }
+}
+
+ISR(USART0_RXC_vect)
+{
+    receive(&console);
+}
+
+ISR(USART0_DRE_vect)
+{
+    send_next(&console);
+}
+
+#if SERIAL_DATA_ENABLE
+ISR(USART1_DRE_vect)
+{
+    send_next(&data);
+}
+#endif
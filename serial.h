@@ -0,0 +1,200 @@
+/*
+ * File:   serial.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 17 October 2026, 21:30
+ */
+
+#ifndef SERIAL_H
+#define	SERIAL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sizes of the receive and transmit ring-buffers of the console. All of the
+// sizes have to be powers of two and at most 256, see ring.h.
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 256
+#endif
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 256
+#endif
+
+// Receive flow control of the console, which asks the other end to pause
+// once the receive ring fills up to the high-water mark, and to go on once
+// the main loop has drained it to the low-water mark.
+typedef enum SERIAL_FLOW {
+    SERIAL_FLOW_NONE,
+    // Sends XOFF and XON. Works over the Curiosity Nano's USB bridge, but
+    // not with the binary protocol, whose frames may contain those bytes.
+    SERIAL_FLOW_XONXOFF,
+    // Drives SERIAL_RTS_VPORT high to pause, for a direct connection.
+    SERIAL_FLOW_RTS,
+} serial_flow;
+
+#ifndef SERIAL_FLOW_DEFAULT
+#define SERIAL_FLOW_DEFAULT SERIAL_FLOW_NONE
+#endif
+// The marks, in bytes in the receive ring. What gets sent after pausing
+// has to fit between the high-water mark and the end of the ring.
+#ifndef SERIAL_RX_HIGH_WATER
+#define SERIAL_RX_HIGH_WATER (SERIAL_RX_BUFFER_SIZE * 3 / 4)
+#endif
+#ifndef SERIAL_RX_LOW_WATER
+#define SERIAL_RX_LOW_WATER (SERIAL_RX_BUFFER_SIZE / 4)
+#endif
+// The RTS pin, active low. PA3 is next to the console's pins.
+#ifndef SERIAL_RTS_VPORT
+#define SERIAL_RTS_VPORT VPORTA
+#define SERIAL_RTS_bm PIN3_bm
+#endif
+
+// Whether to drive USART1 (TX on PC0) as a send-only data channel, so bulk
+// output doesn't have to share the console's link. See channel.h.
+#ifndef SERIAL_DATA_ENABLE
+#define SERIAL_DATA_ENABLE 1
+#endif
+#ifndef SERIAL_DATA_TX_BUFFER_SIZE
+#define SERIAL_DATA_TX_BUFFER_SIZE 256
+#endif
+
+// The baud rate the ports start at, and the console falls back to.
+#ifndef SERIAL_DEFAULT_BAUD
+#define SERIAL_DEFAULT_BAUD 9600
+#endif
+
+// The most the actual baud rate may be off from the requested one, in
+// hundredths of a percent. Receivers typically cope with about 2 %.
+#ifndef SERIAL_BAUD_TOLERANCE
+#define SERIAL_BAUD_TOLERANCE 200
+#endif
+
+// After changing the baud rate, how long to wait for a valid byte from the
+// other end before deciding it can't follow, and going back to the default.
+// Only for ports which receive.
+#ifndef SERIAL_BAUD_FALLBACK_SECONDS
+#define SERIAL_BAUD_FALLBACK_SECONDS 10
+#endif
+
+// What to do when more is written to a port than it can send.
+typedef enum SERIAL_TX_POLICY {
+    // Wait until there is room in the buffer.
+    SERIAL_TX_BLOCK,
+    // Throw away the oldest unsent byte to make room for the new one.
+    SERIAL_TX_DROP_OLDEST,
+    // Throw away the byte being written.
+    SERIAL_TX_DROP_NEWEST,
+} serial_tx_policy;
+
+#ifndef SERIAL_TX_DEFAULT_POLICY
+#define SERIAL_TX_DEFAULT_POLICY SERIAL_TX_BLOCK
+#endif
+// Bulk data rather gets lost than holds up the shell.
+#ifndef SERIAL_DATA_TX_DEFAULT_POLICY
+#define SERIAL_DATA_TX_DEFAULT_POLICY SERIAL_TX_DROP_NEWEST
+#endif
+
+typedef struct SERIAL_BAUD {
+    // What was asked for, and what the divider actually gives.
+    uint32_t rate;
+    uint32_t actual;
+    // How far off `actual` is, in hundredths of a percent.
+    int16_t error;
+    // The value of the BAUD register, with 6 fractional bits.
+    uint16_t divider;
+    // Whether the USART runs at double speed (CLK2X), sampling each bit 8
+    // times instead of 16. Needed for the highest rates.
+    bool double_speed;
+} serial_baud;
+
+typedef struct SERIAL_TX_STATS {
+    // Bytes thrown away by either of the dropping policies.
+    uint32_t dropped;
+    // Bytes which had to wait for room in the buffer.
+    uint32_t blocked;
+} serial_tx_stats;
+
+typedef struct SERIAL_RX_STATS {
+    // Bytes lost because the receive ring was full.
+    uint32_t overruns;
+    // Bytes lost because the ISR didn't get to the USART in time.
+    uint32_t hw_overruns;
+    // Bytes thrown away because they weren't framed right, which usually
+    // means the other end uses a different baud rate.
+    uint32_t framing_errors;
+    // How many times flow control asked the other end to pause.
+    uint32_t throttles;
+    // The fullest the receive ring has been, out of `capacity` bytes.
+    uint8_t high_water;
+    uint8_t capacity;
+} serial_rx_stats;
+
+typedef struct SERIAL_PORT serial_port;
+
+// USART0, which the shell runs on.
+extern serial_port *const serial_console;
+// USART1, or NULL if SERIAL_DATA_ENABLE is off.
+extern serial_port *const serial_data;
+
+// Sets up the ports, and makes the console the standard output.
+void serial_init(void);
+
+// The stream writing to the port.
+FILE *serial_stream(serial_port *port);
+
+void serial_set_tx_policy(serial_port *port, serial_tx_policy policy);
+serial_tx_policy serial_get_tx_policy(serial_port *port);
+
+void serial_get_tx_stats(serial_port *port, serial_tx_stats *stats);
+void serial_clear_tx_stats(serial_port *port);
+
+// Takes the oldest received character. Returns false if there isn't one.
+bool serial_read_char(serial_port *port, char *c);
+bool serial_rx_pending(serial_port *port);
+
+// The receive ring itself, for consumers which want to use the received
+// data in place. See `ring_scan`.
+struct RING *serial_rx_ring(serial_port *port);
+
+// Only the console has flow control.
+void serial_set_flow(serial_port *port, serial_flow flow);
+serial_flow serial_get_flow(serial_port *port);
+
+void serial_get_rx_stats(serial_port *port, serial_rx_stats *stats);
+void serial_clear_rx_stats(serial_port *port);
+
+// Works out the settings which get closest to `rate` with a clock of
+// `clock_hz`. Returns false if the result would be off by more than
+// SERIAL_BAUD_TOLERANCE.
+bool serial_compute_baud(uint32_t rate, uint32_t clock_hz,
+        serial_baud *baud);
+
+// Switches to `baud` once everything written so far has been sent, the next
+// time `serial_poll` runs. If the port receives, it'll be switched back to
+// the default rate unless something valid is received within
+// SERIAL_BAUD_FALLBACK_SECONDS.
+void serial_request_baud(serial_port *port, const serial_baud *baud);
+void serial_get_baud(serial_port *port, serial_baud *baud);
+
+// Keeps the baud rates after the clock has changed, or falls back to the
+// default where they can't be had anymore. See clock.h.
+void serial_clock_changed(void);
+
+// Takes care of baud rate changes. Meant to be called from the main loop,
+// which gets woken up by the ticks once a second, see ticks.h.
+void serial_poll(void);
+
+// Waits until everything written so far has left the port.
+void serial_flush(serial_port *port);
+void serial_flush_all(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SERIAL_H */
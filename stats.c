@@ -0,0 +1,93 @@
+/*
+ * File:   stats.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 09:05
+ */
+
+#include "stats.h"
+#include <string.h>
+
+void stats_init(stats *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->min = UINT16_MAX;
+}
+
+void stats_add(stats *s, uint16_t value)
+{
+    if (s->count == STATS_MAX_COUNT)
+    {
+        return;
+    }
+
+    ++s->count;
+    if (value < s->min)
+    {
+        s->min = value;
+    }
+    if (value > s->max)
+    {
+        s->max = value;
+    }
+    s->sum += value;
+    s->sum_squares += (uint32_t) value * value;
+}
+
+// Rounds to the nearest, for a non-zero `divisor`.
+static uint64_t divide(uint64_t dividend, uint32_t divisor)
+{
+    return (dividend + divisor / 2) / divisor;
+}
+
+// The square root, rounded to the nearest. Works out one bit at a time,
+// since there's no hardware to divide with.
+static uint16_t square_root(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    // What's left over says whether the root is nearer the next integer.
+    if (value > root)
+    {
+        ++root;
+    }
+    return (uint16_t) root;
+}
+
+void stats_finish(const stats *s, stats_result *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (s->count == 0)
+    {
+        return;
+    }
+
+    result->min = s->min;
+    result->max = s->max;
+    result->mean = (uint16_t) divide(s->sum, s->count);
+    // n * sum(x^2) - sum(x)^2 is exact, and never negative. Dividing by n
+    // only at the end keeps it from rounding twice.
+    uint32_t n_squared = (uint32_t) s->count * s->count;
+    uint64_t spread = (uint64_t) s->count * s->sum_squares
+            - (uint64_t) s->sum * s->sum;
+    result->variance = (uint32_t) divide(spread, n_squared);
+    result->stddev = square_root(result->variance);
+    result->rms = square_root((uint32_t) divide(s->sum_squares, s->count));
+}
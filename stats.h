@@ -0,0 +1,58 @@
+/*
+ * File:   stats.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 09:05
+ */
+
+#ifndef STATS_H
+#define	STATS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Statistics of a run of samples, reduced on the fly so the samples
+// themselves needn't be kept.
+//
+// The sums are exact integers, wide enough for STATS_MAX_COUNT samples of
+// the full 16 bits, so nothing is lost to rounding or overflow before the
+// very end.
+
+#define STATS_MAX_COUNT UINT16_MAX
+
+typedef struct STATS {
+    uint16_t count;
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint64_t sum_squares;
+} stats;
+
+// Each of these rounded to the nearest integer.
+typedef struct STATS_RESULT {
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    // The variance of the whole population, not of a sample of it.
+    uint32_t variance;
+    uint16_t stddev;
+    // The root of the mean square.
+    uint16_t rms;
+} stats_result;
+
+void stats_init(stats *s);
+
+// Adds a sample. Ones past STATS_MAX_COUNT are ignored.
+void stats_add(stats *s, uint16_t value);
+
+// Works out the results. All zero if there are no samples.
+void stats_finish(const stats *s, stats_result *result);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* STATS_H */
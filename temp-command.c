@@ -6,87 +6,73 @@
  */
 
 #include "temp-command.h"
-#include <string.h>
 #include "util.h"
+#include "reply.h"
+#include "adc.h"
+#include <stdio.h>
 #include <avr/io.h>
-#include <inttypes.h>
 
 static void temp_command_init(void);
-static bool temp_command_execute(char *arglist, const char *arglist_end);
-static void temp_command_print_help_text(void);
+static command_status temp_command_execute(const command_args *args);
+
+static const command_form temp_forms[] = {
+    {
+        .help = "Prints the internal temperature in degrees Celsius",
+    },
+};
 
 const command temp_cmd = {
     .name = "TEMP",
     .short_help_blurb = "Displays the internal temperature",
 
+    .forms = temp_forms,
+    .form_count = ARRAY_LEN(temp_forms),
+
     .init = &temp_command_init,
     .execute = &temp_command_execute,
-    .print_help_text = &temp_command_print_help_text,
 };
 
 static void temp_command_init(void)
 {
 }
 
-static bool temp_command_execute(char *arglist, const char *arglist_end)
+// The sensor wants the 1.1 V reference, the smaller sampling capacitance,
+// and a delay before the first sample. 64 conversions are added up and
+// averaged below.
+static const adc_config sensor_config = {
+    .muxpos = ADC_MUXPOS_TEMPSENSE_gc,
+    .reference = VREF_ADC0REFSEL_1V1_gc,
+    .sampnum = ADC_SAMPNUM_ACC64_gc,
+    .initdly = ADC_INITDLY_DLY64_gc,
+    .sampcap = true,
+};
+
+static command_status temp_command_execute(const command_args *args)
 {
-    char *arg = arglist;
-    // If we got arguments, bail since this command takes no args.
-    if (iterate_args(&arg, &arglist, arglist_end))
+    (void) args;
+
+    uint16_t result;
+    if (!adc_convert(&sensor_config, &result))
     {
-        printf("TEMP: Unknown argument: %s\r\n", arg);
-        return false;
+        reply_error("The ADC is busy");
+        return COMMAND_FAILED;
     }
-    else
-    {
-        // Save all vrefs and such temporarily.
-        uint8_t temp_voltage = VREF.CTRLA;
-        uint8_t temp_adc0c = ADC0.CTRLC;
-        uint8_t temp_muxpos = ADC0.MUXPOS;
-        uint8_t temp_adc0d = ADC0.CTRLD;
-        uint8_t temp_sample = ADC0.SAMPCTRL;
-
-        // And set relevant values for temperature measurement
-        VREF.CTRLA = VREF_ADC0REFSEL_1V1_gc | ADC_RESSEL_10BIT_gc;
-        ADC0.CTRLC = ADC_REFSEL_INTREF_gc | (1 << ADC_SAMPCAP_bp)
-                | ADC_PRESC_DIV4_gc;
-        ADC0.MUXPOS = ADC_MUXPOS_TEMPSENSE_gc;
-        ADC0.CTRLD = ADC_INITDLY_DLY64_gc;
-        ADC0.SAMPCTRL = ADC_SAMPNUM_ACC64_gc;
-
-        int8_t sigrow_offset = SIGROW.TEMPSENSE1;
-        uint8_t sigrow_gain = SIGROW.TEMPSENSE0;
 
-        // Now the ADC is set so it can read the temperature.
-        // Read it!
-        ADC0.COMMAND = ADC_STCONV_bm;
-        // Wait until it's done
-        while (!(ADC0.INTFLAGS & ADC_RESRDY_bm));
-        // And now read the result. Also clears interrupt flag
-        uint16_t result = ADC0.RES;
-        // First turn it into Kelvin.
-        int32_t temp = result - sigrow_offset;
-        temp *= sigrow_gain;
-        temp += 0x0080; // Round to degree
-        temp >>= 8; // And now it's Kelvin!
+    int8_t sigrow_offset = SIGROW.TEMPSENSE1;
+    uint8_t sigrow_gain = SIGROW.TEMPSENSE0;
 
-        int32_t celsius = temp - 273;
+    // First turn it into Kelvin. The calibration is for a single
+    // conversion, so the offset is scaled up to the sum of 64, and the
+    // result back down by the same 6 bits.
+    int32_t temp = result - (int32_t) sigrow_offset * 64;
+    temp *= sigrow_gain;
+    temp += 0x2000; // Round to degree
+    temp >>= 8 + 6; // And now it's Kelvin!
 
-        // Restore previous values.
-        ADC0.SAMPCTRL = temp_sample;
-        ADC0.CTRLD = temp_adc0d;
-        ADC0.MUXPOS = temp_muxpos;
-        ADC0.CTRLC = temp_adc0c;
-        VREF.CTRLA = temp_voltage;
+    int32_t celsius = temp - 273;
 
-        printf("Internal temperature is %"PRId32" degrees Celsius\r\n",
-                celsius);
+    reply_i16("celsius", "Internal temperature (C)",
+            (int16_t) celsius);
 
-        return true;
-    }
+    return COMMAND_OK;
 }
-
-static void temp_command_print_help_text(void)
-{
-    printf("\tTEMP\tPrints the internal temperature in degrees Celsius\r\n");
-}
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*
+ * File:   ticks.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 03:10
+ */
+
+#include "ticks.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+static volatile uint32_t seconds = 0;
+
+void ticks_init(void)
+{
+    // The RTC registers can't be written while they're synchronising.
+    while (RTC.STATUS != 0);
+
+    RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
+    // 32768 Hz divided by 32 gives the ticks, and a full second of them
+    // makes the counter wrap.
+    RTC.PER = TICKS_PER_SECOND - 1;
+    RTC.INTCTRL = RTC_OVF_bm;
+    RTC.CTRLA = RTC_PRESCALER_DIV32_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+}
+
+uint32_t ticks_now(void)
+{
+    uint32_t whole;
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        whole = seconds;
+        count = RTC.CNT;
+        // The counter may have wrapped without the interrupt having had
+        // a chance to count it yet.
+        if ((RTC.INTFLAGS & RTC_OVF_bm) && (count < TICKS_PER_SECOND / 2))
+        {
+            ++whole;
+        }
+    }
+    return whole * TICKS_PER_SECOND + count;
+}
+
+bool ticks_passed(uint32_t deadline)
+{
+    // Works across the wrap-around, as long as the deadline is less than
+    // half the range away.
+    return (int32_t) (ticks_now() - deadline) >= 0;
+}
+
+ISR(RTC_CNT_vect)
+{
+    RTC.INTFLAGS = RTC_OVF_bm;
+    ++seconds;
+}
@@ -0,0 +1,37 @@
+/*
+ * File:   ticks.h
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 03:10
+ */
+
+#ifndef TICKS_H
+#define	TICKS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A free-running time base for timeouts, counted by the RTC from the
+// internal 32 kHz oscillator so it doesn't depend on the CPU clock.
+#define TICKS_PER_SECOND 1024
+
+// Starts the RTC. The RTC interrupts once a second, which also wakes the
+// main loop up to check on timeouts. The RTC's periodic interrupt is left
+// to the LED patterns, see led-command.c.
+void ticks_init(void);
+
+// Ticks since `ticks_init`. Wraps around after about 48 days.
+uint32_t ticks_now(void);
+
+// Whether `deadline`, as a value of `ticks_now`, has passed.
+bool ticks_passed(uint32_t deadline);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TICKS_H */
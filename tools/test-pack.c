@@ -0,0 +1,221 @@
+/*
+ * File:   test-pack.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 11:20
+ */
+
+// Round-trips blocks made by pack_write through the decoder, see pack.h and
+// unpack-samples.c. Run with `make -C tools test`, which passes the path of
+// the decoder as the only argument.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "../pack.h"
+
+#define PACKED_FILE "test-pack.bin"
+#define DECODED_FILE "test-pack.out"
+#define MAX_SAMPLES 32768
+
+static uint16_t expected[MAX_SAMPLES];
+static size_t expected_count;
+static FILE *packed;
+
+static uint32_t random_state = 12345;
+
+// A fixed sequence, so that any failure can be repeated.
+static uint32_t random_next(void)
+{
+    random_state = random_state * 1103515245UL + 12345;
+    return random_state >> 8;
+}
+
+static void add_block(const uint16_t *samples, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        expected[expected_count++] = samples[i];
+    }
+    pack_write(packed, samples, count);
+}
+
+static void add_sine_blocks(void)
+{
+    uint16_t samples[32];
+    static double phase = 0;
+    for (int block = 0; block < 64; ++block)
+    {
+        for (int i = 0; i < 32; ++i)
+        {
+            samples[i] = (uint16_t) (512 + 400 * sin(phase));
+            phase += 0.01;
+        }
+        add_block(samples, 32);
+    }
+}
+
+static void add_noise_blocks(uint16_t mask)
+{
+    uint16_t samples[255];
+    for (int block = 0; block < 16; ++block)
+    {
+        for (int i = 0; i < 255; ++i)
+        {
+            samples[i] = random_next() & mask;
+        }
+        add_block(samples, 255);
+    }
+}
+
+static void add_random_length_blocks(void)
+{
+    uint16_t samples[255];
+    for (int block = 0; block < 64; ++block)
+    {
+        uint8_t count = 1 + random_next() % 255;
+        uint16_t mask = (1U << (random_next() % 17)) - 1;
+        uint16_t base = random_next();
+        for (int i = 0; i < count; ++i)
+        {
+            samples[i] = base + (random_next() & mask);
+        }
+        add_block(samples, count);
+    }
+}
+
+static long file_size(const char *name)
+{
+    FILE *f = fopen(name, "rb");
+    if (f == NULL)
+    {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+// Runs the decoder on `input`. Returns its exit status.
+static int decode(const char *decoder, const char *input)
+{
+    char command[512];
+    snprintf(command, sizeof(command), "%s < %s > %s", decoder, input,
+            DECODED_FILE);
+    return system(command);
+}
+
+static bool check_decoded(void)
+{
+    FILE *f = fopen(DECODED_FILE, "r");
+    if (f == NULL)
+    {
+        return false;
+    }
+    size_t i = 0;
+    unsigned value;
+    while (fscanf(f, "%u", &value) == 1)
+    {
+        if ((i >= expected_count) || (value != expected[i]))
+        {
+            fprintf(stderr, "test-pack: Sample %zu is %u\n", i, value);
+            fclose(f);
+            return false;
+        }
+        ++i;
+    }
+    fclose(f);
+    if (i != expected_count)
+    {
+        fprintf(stderr, "test-pack: Got %zu of %zu samples\n", i,
+                expected_count);
+        return false;
+    }
+    return true;
+}
+
+// Cuts the packed file short by `cut` bytes into a file of its own.
+static const char *truncated(long cut)
+{
+    static const char *name = "test-pack-cut.bin";
+    long size = file_size(PACKED_FILE);
+    FILE *in = fopen(PACKED_FILE, "rb");
+    FILE *out = fopen(name, "wb");
+    for (long i = 0; i < size - cut; ++i)
+    {
+        putc(getc(in), out);
+    }
+    fclose(in);
+    fclose(out);
+    return name;
+}
+
+// A whole block followed by half of the next one's header.
+static const char *half_header(void)
+{
+    static const char *name = "test-pack-cut.bin";
+    const uint16_t samples[] = { 1, 2, 3, };
+    FILE *out = fopen(name, "wb");
+    pack_write(out, samples, 3);
+    putc(3, out);
+    putc(2, out);
+    fclose(out);
+    return name;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok)
+    {
+        ++failures;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: test-pack <unpack-samples>\n");
+        return EXIT_FAILURE;
+    }
+    const char *decoder = argv[1];
+
+    packed = fopen(PACKED_FILE, "wb");
+    add_sine_blocks();
+    fclose(packed);
+    double per_sample = (double) file_size(PACKED_FILE) / expected_count;
+    check((decode(decoder, PACKED_FILE) == 0) && check_decoded(),
+            "slow sine");
+    printf("      %.2f bytes a sample\n", per_sample);
+    check(per_sample < 1.0, "slow sine packs below a byte a sample");
+
+    packed = fopen(PACKED_FILE, "ab");
+    add_noise_blocks(0x03FF);
+    fclose(packed);
+    check((decode(decoder, PACKED_FILE) == 0) && check_decoded(),
+            "10-bit noise");
+
+    packed = fopen(PACKED_FILE, "ab");
+    add_noise_blocks(0xFFFF);
+    fclose(packed);
+    check((decode(decoder, PACKED_FILE) == 0) && check_decoded(),
+            "16-bit noise");
+
+    packed = fopen(PACKED_FILE, "ab");
+    add_random_length_blocks();
+    fclose(packed);
+    check((decode(decoder, PACKED_FILE) == 0) && check_decoded(),
+            "random lengths");
+
+    check(decode(decoder, truncated(1)) != 0, "truncated block");
+    check(decode(decoder, half_header()) != 0, "truncated header");
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,92 @@
+/*
+ * File:   unpack-samples.c
+ * Author: Jani Juhani Sinervo
+ *
+ * Created on 18 October 2026, 10:50
+ */
+
+// Decodes the packed blocks of ADC STREAM and ADC DUMP, see pack.h, on the
+// host. Reads the blocks from standard input, and prints the samples one
+// to a line. Build it with `make -C tools`, and test it against pack.c
+// with `make -C tools test`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../pack.h"
+
+// Reads `count` bytes. Returns false at the end of the input.
+static bool read_bytes(uint8_t *buffer, size_t count)
+{
+    return fread(buffer, 1, count, stdin) == count;
+}
+
+// Decodes one block into `samples`. Returns the number of samples, zero at
+// the end of the input, or -1 if the block is broken.
+static int unpack_block(uint16_t *samples)
+{
+    uint8_t header[PACK_HEADER_SIZE];
+    if (!read_bytes(header, 1))
+    {
+        return 0;
+    }
+    if (!read_bytes(&header[1], PACK_HEADER_SIZE - 1))
+    {
+        return -1;
+    }
+
+    uint8_t count = header[0];
+    uint8_t width = header[1];
+    if ((count == 0) || (width > PACK_MAX_WIDTH))
+    {
+        return -1;
+    }
+    samples[0] = header[2] | (header[3] << 8);
+
+    uint8_t packed[PACK_BLOCK_SIZE(255, PACK_MAX_WIDTH)];
+    size_t length = PACK_BLOCK_SIZE(count, width) - PACK_HEADER_SIZE;
+    if (!read_bytes(packed, length))
+    {
+        return -1;
+    }
+
+    uint32_t bits = 0;
+    uint8_t available = 0;
+    size_t next = 0;
+    for (int i = 1; i < count; ++i)
+    {
+        while (available < width)
+        {
+            bits |= (uint32_t) packed[next++] << available;
+            available += 8;
+        }
+        uint16_t zigzag = bits & ((1UL << width) - 1);
+        bits >>= width;
+        available -= width;
+        samples[i] = (uint16_t) (samples[i - 1] + PACK_UNZIGZAG(zigzag));
+    }
+    return count;
+}
+
+int main(void)
+{
+    uint16_t samples[255];
+    int count;
+    unsigned long blocks = 0;
+    while ((count = unpack_block(samples)) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            printf("%u\n", samples[i]);
+        }
+        ++blocks;
+    }
+    if (count < 0)
+    {
+        fprintf(stderr, "unpack-samples: Block %lu is broken\n", blocks);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
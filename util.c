@@ -9,35 +9,138 @@
 #include <ctype.h>
 #include <stdlib.h>
 
-const char *iterate_args(char **pos,
-        char **next_pos,
-        const char *arg_list_end)
+static int discard_char(char c, FILE *stream);
+
+static FILE discard_stream = FDEV_SETUP_STREAM(discard_char,
+        NULL, _FDEV_SETUP_WRITE);
+
+void arg_list_init(arg_list *args, char *start, char *end,
+        char *wrapped, char *wrapped_end)
+{
+    args->pos = start;
+    args->end = end;
+    args->wrapped = wrapped;
+    args->wrapped_end = wrapped_end;
+    args->too_long = false;
+}
+
+// Earlier calls leave NUL bytes behind, so those separate arguments too.
+static bool is_separator(char c)
 {
-    // Are we at the end of the argument list?
-    if (*pos >= arg_list_end) {
-        // If so, scram.
+    return (c == '\0') || isspace(c);
+}
+
+// Moves on to the second piece of the line, if there is one.
+static bool next_piece(arg_list *args)
+{
+    if (args->wrapped == NULL)
+    {
+        return false;
+    }
+
+    args->pos = args->wrapped;
+    args->end = args->wrapped_end;
+    args->wrapped = NULL;
+    return true;
+}
+
+const char *iterate_args(arg_list *args)
+{
+    // Skip any excess whitespace, possibly all the way into the second piece.
+    while (true)
+    {
+        if (args->pos >= args->end)
+        {
+            // Are we at the end of the argument list? If so, scram.
+            if (!next_piece(args))
+            {
+                return NULL;
+            }
+        }
+        else if (is_separator(*args->pos))
+        {
+            ++args->pos;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    // And iterate until next whitespace or the end of the piece.
+    char *arg = args->pos;
+    while ((args->pos < args->end) && !is_separator(*args->pos))
+    {
+        ++args->pos;
+    }
+
+    if ((args->pos < args->end) || (args->wrapped == NULL))
+    {
+        // The argument ends within this piece, or at the end of the line.
+        // Either way there's a byte we can replace with a NUL.
+        *args->pos = '\0';
+        if (args->pos < args->end)
+        {
+            ++args->pos;
+        }
+        return arg;
+    }
+
+    // The argument runs to the end of the first piece, past which we can't
+    // write. So gather it into the straddle buffer instead, along with
+    // however much of it continues in the second piece.
+    size_t length = 0;
+    for (char *c = arg; c < args->end; ++c)
+    {
+        if (length + 1 < ARG_STRADDLE_SIZE)
+        {
+            args->straddle[length] = *c;
+        }
+        ++length;
+    }
+    next_piece(args);
+    while ((args->pos < args->end) && !is_separator(*args->pos))
+    {
+        if (length + 1 < ARG_STRADDLE_SIZE)
+        {
+            args->straddle[length] = *args->pos;
+        }
+        ++length;
+        ++args->pos;
+    }
+
+    if (length >= ARG_STRADDLE_SIZE)
+    {
+        args->too_long = true;
         return NULL;
     }
-    
-    // Otherwise skip any excess whitespace.
-    char *iter = *pos;
-    while (isspace(*iter)) {
-        ++iter;
-    }
-    *pos = iter;
-    
-    // And iterate until next whitespace or NUL
-    while (!(*iter == '\0' || isspace(*iter))) {
-        ++iter;
-    }
-    
-    // We've reached the end of the current argument.
-    // If it's a space, we can replace it with a NUL byte.
-    if (isspace(*iter)) {
-        *iter = '\0';
-    }
-    *next_pos = iter + 1;
-    // Otherwise, since it's not a space it has to be the existing NUL-byte
-    // and thus the end of this string.
-    return *pos;
-}
\ No newline at end of file
+    args->straddle[length] = '\0';
+    return args->straddle;
+}
+
+args_status tokenize_args(arg_list *args, const char **argv, uint8_t max,
+        uint8_t *argc)
+{
+    *argc = 0;
+    for (const char *arg; (arg = iterate_args(args)) != NULL;)
+    {
+        if (*argc == max)
+        {
+            return ARGS_TOO_MANY;
+        }
+        argv[(*argc)++] = arg;
+    }
+    return args->too_long ? ARGS_TOO_LONG : ARGS_OK;
+}
+
+static int discard_char(char c, FILE *stream)
+{
+    (void) c;
+    (void) stream;
+    return 0;
+}
+
+FILE *null_stream(void)
+{
+    return &discard_stream;
+}
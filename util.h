@@ -12,29 +12,80 @@
 extern "C" {
 #endif
 
-// Iterates through a given argument position, giving each space-separated
-// argument as a return value.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// An argument crossing the point where a line wraps around gets copied into
+// a buffer of this size. Longer ones are an error rather than getting cut
+// short, since a cut list of numbers can still look valid.
+#ifndef ARG_STRADDLE_SIZE
+#define ARG_STRADDLE_SIZE 64
+#endif
+
+// The most arguments a command line can have, the command name included.
+#ifndef ARGS_MAX
+#define ARGS_MAX 8
+#endif
+
+// The space-separated arguments of a command line.
+//
+// The line is parsed in place, wherever it happens to be stored. If it's
+// stored in a ring-buffer it might be split in two pieces, with the second
+// one starting from `wrapped`.
+typedef struct ARG_LIST {
+    char *pos;
+    char *end;
+    char *wrapped;
+    char *wrapped_end;
+    // Set when an argument didn't fit in `straddle`.
+    bool too_long;
+    char straddle[ARG_STRADDLE_SIZE];
+} arg_list;
+
+typedef enum ARGS_STATUS {
+    ARGS_OK,
+    // More arguments than there was room for.
+    ARGS_TOO_MANY,
+    // An argument didn't fit in the straddle buffer.
+    ARGS_TOO_LONG,
+} args_status;
+
+// Sets up `args` to go through the line [start, end), optionally continuing
+// at [wrapped, wrapped_end). The byte at the end of the last piece has to be
+// writable, since it gets replaced with a NUL. `wrapped` can be NULL.
+void arg_list_init(arg_list *args, char *start, char *end,
+        char *wrapped, char *wrapped_end);
+
+// Iterates through the arguments, giving each space-separated argument as a
+// return value.
 //
 // Example:
 //
-// char *foo = "bar baz";
-// const char *foo_end = foo + strlen(foo);
+// char foo[] = "bar baz";
+// arg_list args;
+// arg_list_init(&args, foo, foo + strlen(foo), NULL, NULL);
 //
-// char *next_arg = NULL;
-// for (char *arg = foo; iterate_args(&arg, &next_arg, foo_end);) {
-//     printf("Arg: %s\", arg);
-//     arg = next_arg;
+// for (const char *arg; (arg = iterate_args(&args)) != NULL;) {
+//     printf("Arg: %s\r\n", arg);
 // }
 // That example will print:
 //
 // Arg: bar
 // Arg: baz
 //
-// Returns NULL after the last argument. Will modify the argument list to add
-// NUL bytes after arguments.
-const char *iterate_args(char **pos,
-        char **next_pos,
-        const char *arg_list_end);
+// Returns NULL after the last argument, and also on an argument too long for
+// the straddle buffer, in which case `too_long` gets set. Will modify the
+// line to add NUL bytes after arguments.
+const char *iterate_args(arg_list *args);
+
+// Splits the rest of the line into `argv` in one pass. Gives at most `max`
+// arguments.
+args_status tokenize_args(arg_list *args, const char **argv, uint8_t max,
+        uint8_t *argc);
+
+// A stream which throws away everything written to it.
+FILE *null_stream(void);
 
 #define ARRAY_LEN(arr) ((sizeof(arr))/(sizeof(*(arr))))
 
@@ -43,4 +94,3 @@ const char *iterate_args(char **pos,
 #endif
 
 #endif	/* UTIL_H */
-
@@ -7,30 +7,17 @@
 
 #include "vref-command.h"
 #include "util.h"
-#include <string.h>
+#include "keyword.h"
+#include "reply.h"
 #include <avr/io.h>
-#include <inttypes.h>
 
 static void vref_command_init(void);
-static bool vref_command_execute(char *arglist, const char *arglist_end);
-static void vref_command_print_help_text(void);
-
-const command vref_cmd = {
-    .name = "VREF",
-    .short_help_blurb = "Displays and sets the reference voltage",
-
-    .init = &vref_command_init,
-    .execute = &vref_command_execute,
-    .print_help_text = &vref_command_print_help_text,
-};
+static command_status vref_command_execute(const command_args *args);
 
+// Sorted by name, see `keyword_lookup`.
 #define A(major, minor) { .name = #major "V" #minor,\
     .value = VREF_ADC0REFSEL_ ## major ## V ## minor ## _gc, }
-static struct
-{
-    const char *name;
-    VREF_ADC0REFSEL_t value;
-} const set_args[] = {
+static const keyword set_args[] = {
     A(0,55),
     A(1,1),
     A(1,5),
@@ -39,75 +26,93 @@ static struct
 };
 #undef A
 
+// A full-scale 10-bit conversion of the reference voltage reads 1023.
+#define SCALE(millivolts) (uint16_t) \
+    ((((uint32_t) (millivolts) << VREF_SCALE_BITS) + 511) / 1023)
+#define R(major, minor, millivolts) \
+    { VREF_ADC0REFSEL_ ## major ## V ## minor ## _gc, SCALE(millivolts), }
+static const struct
+{
+    uint8_t refsel;
+    uint16_t scale;
+} scales[] = {
+    R(0,55, 550),
+    R(1,1, 1100),
+    R(1,5, 1500),
+    R(2,5, 2500),
+    R(4,34, 4340),
+};
+#undef R
+#undef SCALE
+
+// Some reasonable reference voltage to start with.
+static uint8_t selected = VREF_ADC0REFSEL_0V55_gc;
+
+enum
+{
+    VREF_FORM_SHOW,
+    VREF_FORM_SET,
+};
+
+static const arg_spec vref_set_args[] = {
+    ARG_SPEC_ENUM(set_args),
+};
+
+// The form without a keyword first, then the rest sorted by keyword.
+static const command_form vref_forms[] = {
+    [VREF_FORM_SHOW] = {
+        .help = "Prints the selected reference voltage",
+    },
+    [VREF_FORM_SET] = {
+        .keyword = "SET", .args = vref_set_args, .required = 1, .count = 1,
+        .help = "Sets the reference voltage",
+    },
+};
+
+const command vref_cmd = {
+    .name = "VREF",
+    .short_help_blurb = "Displays and sets the reference voltage",
+
+    .forms = vref_forms,
+    .form_count = ARRAY_LEN(vref_forms),
+
+    .init = &vref_command_init,
+    .execute = &vref_command_execute,
+};
+
 static void vref_command_init(void)
 {
-    // Set some reasonable reference voltage
-    VREF.CTRLA |= VREF_ADC0REFSEL_0V55_gc;
 }
 
-static bool vref_command_execute(char *arglist, const char *arglist_end)
+static command_status vref_command_execute(const command_args *args)
 {
-    char *arg = arglist;
-    // If we got arguments, check if it's a SET command
-    if (iterate_args(&arg, &arglist, arglist_end))
+    if (args->form == VREF_FORM_SET)
     {
-        if (strcasecmp(arg, "SET") != 0) {
-            printf("VREF: Unknown argument: %s\r\n", arg);
-            return false;
-        }
-        
-        arg = arglist;
-        // Now check whether we have a required parameter...
-        if (!iterate_args(&arg, &arglist, arglist_end))
-        {
-            printf("VREF: Usage: VREF SET %s\r\n",
-                    "[0V55|1V1|1V5|2V5|4V34]");
-            return false;
-        }
-        // ...and if we do, check its validity.
-        bool found_voltage = false;
-        VREF_ADC0REFSEL_t voltage;
-        for (size_t i = 0; i < ARRAY_LEN(set_args); ++i)
-        {
-            if (strcasecmp(set_args[i].name, arg) == 0)
-            {
-                found_voltage = true;
-                voltage = set_args[i].value;
-                break;
-            }
-        }
-        
-        if (!found_voltage)
-        {
-            printf("VREF: Usage: VREF SET %s\r\n",
-                    "[0V55|1V1|1V5|2V5|4V34]");
-            return false;
-        }
-        
-        VREF.CTRLA = voltage;        
+        // Takes effect with the next conversion.
+        selected = (uint8_t) args->values[0].number;
     }
     else
     {
-        uint8_t voltage = VREF.CTRLA;
-        // 3 bits set at the proper position, i.e.
-        // 0b01110000
-        const uint8_t voltage_mask = 7 << 4;
-        // Otherwise, just print the selected reference voltage.
-        for (size_t i = 0; i < ARRAY_LEN(set_args); ++i)
-        {
-            if ((voltage & voltage_mask) == set_args[i].value)
-            {
-                printf("Current reference voltage: %s\r\n", set_args[i].name);
-                break;
-            }
-        }
+        // Otherwise, just report the selected reference voltage.
+        reply_keyword("voltage", "Current reference voltage", set_args,
+                ARRAY_LEN(set_args), selected);
     }
-    return true;
+    return COMMAND_OK;
+}
+
+uint8_t vref_adc_reference(void)
+{
+    return selected;
 }
 
-static void vref_command_print_help_text(void)
+uint16_t vref_adc_scale(void)
 {
-    printf("\tVREF\tPrints the selected reference voltage\r\n");
-    printf("\tVREF SET %s\tSets the reference voltage\r\n",
-            "[0V55|1V1|1V5|2V5|4V34]");
-}
\ No newline at end of file
+    for (uint8_t i = 0; i < ARRAY_LEN(scales); ++i)
+    {
+        if (scales[i].refsel == selected)
+        {
+            return scales[i].scale;
+        }
+    }
+    return 0;
+}
@@ -16,6 +16,17 @@ extern "C" {
     
 extern const command vref_cmd;
 
+// The fraction bits of `vref_adc_scale`.
+#define VREF_SCALE_BITS 12
+
+// The reference selected for the ADC, VREF_ADC0REFSEL_*. The ADC driver
+// sets it up for each conversion, see adc.h.
+uint8_t vref_adc_reference(void);
+
+// Millivolts per count of a 10-bit conversion with the selected reference,
+// as a fixed-point number with VREF_SCALE_BITS fraction bits.
+uint16_t vref_adc_scale(void);
+
 #ifdef	__cplusplus
 }
 #endif